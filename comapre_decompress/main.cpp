@@ -4,12 +4,10 @@
 #include <sstream>
 #include <vector>
 #include <map>
-#include <chrono>
 #include <iomanip>
 #define FNV1A_64_INIT 0xcbf29ce484222325ULL
 #define FNV1A_64_PRIME 0x100000001b3
 using namespace std;
-using namespace chrono;
 
 // 解码树节点结构
 struct DecodeNode {
@@ -175,7 +173,6 @@ public:
             return false;
         }
 
-        auto startTime = high_resolution_clock::now();
 
         DecodeNode* current = root;
         long decodedSize = 0;
@@ -203,15 +200,8 @@ public:
             } while (decodedSize < originalFileSize);
         }
 
-        auto endTime = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(endTime - startTime);
-        
-        
-
         cout << "\n解压缩统计信息：" << endl;
         cout << "----------------------------------------" << endl;
-        cout << "解压耗时: " << fixed << setprecision(6) 
-             << duration.count() / 1000000.0 << " 秒" << endl;
         cout << "已解码大小: " << decodedSize << " 字节" << endl;
         cout << "----------------------------------------" << endl;
 
@@ -244,7 +234,6 @@ public:
             return false;
         }
 
-        auto startTime = high_resolution_clock::now();
 
         string currentCode;
         long decodedSize = 0;
@@ -265,13 +254,8 @@ public:
             }
         }
 
-        auto endTime = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(endTime - startTime);
-
         cout << "\n映射表解压统计信息：" << endl;
         cout << "----------------------------------------" << endl;
-        cout << "解压耗时: " << fixed << setprecision(6) 
-             << duration.count() / 1000000.0 << " 秒" << endl;
         cout << "已解码大小: " << decodedSize << " 字节" << endl;
         cout << "----------------------------------------" << endl;
 
@@ -293,6 +277,7 @@ int main() {
     cout << "请输入压缩文件路径(.hfm): ";
     getline(cin, compressedFile);
 
+    // 两种解码方式的速度由 huffman_benchmark 在内存中比较（不含文件读写）
     // 加载编码表并解压
     if (!decompressor.loadCodeTable("code.txt") || 
         !decompressor.decompress(compressedFile)) {
@@ -4,12 +4,13 @@
 #include <sstream>
 #include <vector>
 #include <map>
-#include <chrono>
 #include <iomanip>
-#define FNV1A_64_INIT 0xcbf29ce484222325ULL
-#define FNV1A_64_PRIME 0x100000001b3
+#include "huffman_table_decoder.h"
+#include "huffman_checksum.h"
+#include "huffman_container.h"
+#include "huffman_parallel.h"
+#include "huffman_archive.h"
 using namespace std;
-using namespace chrono;
 
 // 解码树节点结构
 struct DecodeNode {
@@ -25,38 +26,59 @@ struct DecodeNode {
 class HuffmanDecompression {
 private:
     DecodeNode* root;
-    long originalFileSize;
+    uint64_t originalFileSize;
+    streamoff payloadOffset = 0;         // 位流在压缩文件中的起始位置
+    bool blockMode = false;              // 分块格式：块间有填充位，只能按块查表解码
+    HfmBlockIndex blockIndex;
+    bool isContainer = false;
+    HfmHeader containerHeader;           // 容器格式记录的校验算法和校验值
+    HfmChecksumIndex checksumIndex;      // 块校验表，unit 为0表示没有
     map<string, unsigned char> codeMap;  // 添加编码映射表
-    uint64_t fnv1a_64(const void *data, size_t length) {
-        uint64_t hash = FNV1A_64_INIT;
-        const uint8_t *byte_data = (const uint8_t *)data;
-        for (size_t i = 0; i < length; i++) {
-            hash ^= byte_data[i];
-            hash *= FNV1A_64_PRIME;
-        }
-        return hash;
+    HuffmanTableDecoder tableDecoder;    // 多级查找表解码器
+
+    // 各解压方式共用的校验器：容器格式按头部记录的算法和块校验表比对，
+    // 旧格式没有记录校验值，只计算 FNV-1a 供显示
+    ChecksumVerifier makeVerifier() const {
+        HfmHeader legacyHeader;
+        legacyHeader.originalSize = originalFileSize;
+        return ChecksumVerifier(isContainer ? containerHeader : legacyHeader, &checksumIndex);
     }
 
-    //计算文件的hash值
-    uint64_t calculateFileHash(const string& filename) {
-        ifstream file(filename, ios::binary);
-        if (!file) {
-            cerr << "无法打开文件进行哈希计算：" << filename << endl;
-            return 0;
-        }
+    // 逐字节解码的输出先攒在缓冲区，满了整块送入校验再写出；块校验失败时返回 false
+    struct CheckedOutput {
+        ofstream& out;
+        ChecksumVerifier& verifier;
+        vector<unsigned char> buffer;
 
-        // 获取文件大小
-        file.seekg(0, ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, ios::beg);
+        CheckedOutput(ofstream& file, ChecksumVerifier& v) : out(file), verifier(v) { buffer.reserve(1 << 16); }
 
-        // 读取文件内容
-        vector<uint8_t> buffer(fileSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-        file.close();
+        bool put(unsigned char byte) {
+            buffer.push_back(byte);
+            return buffer.size() < (1 << 16) || flush();
+        }
+
+        bool flush() {
+            bool ok = verifier.update(buffer.data(), buffer.size());
+            if (ok) out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            buffer.clear();
+            return ok;
+        }
+    };
 
-        // 计算哈希值
-        return fnv1a_64(buffer.data(), fileSize);
+    // 显示解压数据的校验值，容器格式同时比对块校验表和整个文件的校验值
+    bool reportChecksum(ChecksumVerifier& verifier) {
+        if (verifier.failed()) {
+            cerr << "块校验失败！第 " << verifier.failedBlock() << " 个校验单元（原始数据偏移 "
+                 << verifier.failedOffset() << " 起）已损坏，已停止解压" << endl;
+            return false;
+        }
+        bool ok = verifier.finish();
+        cout << "解压文件哈希值: " << formatChecksum(verifier.algorithm(), verifier.value()) << endl;
+        if (isContainer && !ok) {
+            cerr << "校验失败！期望哈希值: " << formatChecksum(verifier.algorithm(), verifier.expectedValue()) << endl;
+            return false;
+        }
+        return true;
     }
 
     // 将十六进制字符串转换为整数
@@ -121,11 +143,16 @@ public:
         // 读取文件大小
         string fileSizeStr;
         getline(codeFile, fileSizeStr);
-        originalFileSize = stol(fileSizeStr);
+        originalFileSize = stoull(fileSizeStr);
+        payloadOffset = 0;
+        blockMode = false;
+        isContainer = false;
+        checksumIndex = HfmChecksumIndex();
         cout << "原文件大小: " << originalFileSize << " 字节" << endl;
 
         // 读取编码表
         string line;
+        vector<pair<unsigned char, CodeWord>> codeWords;
         while (getline(codeFile, line)) {
             if (line.empty()) continue;
 
@@ -148,12 +175,82 @@ public:
             code = code.substr(0, length);
             buildDecodeTree(byte, code);
             codeMap[code] = byte;
+
+            CodeWord word;
+            if (!codeStringToWord(code, word)) {
+                cerr << "编码长度超过64位！" << endl;
+                return false;
+            }
+            codeWords.emplace_back(byte, word);
         }
 
         codeFile.close();
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
         return true;
     }
 
+    // 从自描述容器头部加载编码表，同时建立解码树、映射表和查找表
+    bool loadContainer(const string& compressedPath) {
+        HfmHeader& header = containerHeader;
+        ifstream inFile(compressedPath, ios::binary);
+        if (!inFile || !readHfmHeader(inFile, header)) {
+            cerr << "无法读取压缩文件头部或头部已损坏！" << endl;
+            return false;
+        }
+        if (header.flags & HFM_FLAG_SYMBOLS) {
+            cerr << "该文件使用多字节符号模式，请使用 decompression_text 解压！" << endl;
+            return false;
+        }
+        originalFileSize = header.originalSize;
+        payloadOffset = static_cast<streamoff>(HFM_HEADER_SIZE);
+        blockMode = (header.flags & HFM_FLAG_BLOCKS) != 0;
+        if (blockMode) {
+            if (!readBlockIndex(inFile, header, blockIndex, streamBytesLeft(inFile))) {
+                cerr << "块索引已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(blockIndex.byteSize());
+        }
+        if (header.flags & HFM_FLAG_SYNC_POINTS) {
+            // 本程序总是完整解压，只需跳过同步点索引
+            HfmSyncIndex syncIndex;
+            if (!readSyncIndex(inFile, header, syncIndex)) {
+                cerr << "同步点索引已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(syncIndex.byteSize());
+        }
+        checksumIndex = HfmChecksumIndex();
+        if (header.flags & HFM_FLAG_BLOCK_CHECKSUMS) {
+            if (!readChecksumIndex(inFile, header, checksumIndex)) {
+                cerr << "块校验表已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(checksumIndex.byteSize());
+        }
+        isContainer = true;
+        cout << "原文件大小: " << originalFileSize << " 字节" << endl;
+
+        vector<pair<unsigned char, CodeWord>> codeWords = codeListFromLengths(header.codeLengths);
+        for (const auto& pair : codeWords) {
+            string code = codeWordToString(pair.second);
+            buildDecodeTree(pair.first, code);
+            codeMap[code] = pair.first;
+        }
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool isBlockMode() const {
+        return blockMode;
+    }
+
     // 解压缩文件
     bool decompress(const string& compressedPath) {
         ifstream inFile(compressedPath, ios::binary);
@@ -161,6 +258,7 @@ public:
             cerr << "无法打开压缩文件！" << endl;
             return false;
         }
+        inFile.seekg(payloadOffset);
 
         string outputPath = compressedPath;
         size_t lastDot = outputPath.find_last_of('.');
@@ -175,14 +273,15 @@ public:
             return false;
         }
 
-        auto startTime = high_resolution_clock::now();
+        ChecksumVerifier verifier = makeVerifier();
+        CheckedOutput output(outFile, verifier);
 
         DecodeNode* current = root;
-        long decodedSize = 0;
+        uint64_t decodedSize = 0;
         char byte;
         unsigned char bitPos = 7;
 
-        while (inFile.get(byte) && decodedSize < originalFileSize) {
+        while (!verifier.failed() && inFile.get(byte) && decodedSize < originalFileSize) {
             unsigned char curByte = static_cast<unsigned char>(byte);
             
             do {
@@ -190,7 +289,7 @@ public:
                 current = bit ? current->right : current->left;
                 
                 if (current && current->isLeaf) {
-                    outFile.put(current->byte);
+                    if (!output.put(current->byte)) break;
                     decodedSize++;
                     current = root;
                 }
@@ -202,25 +301,16 @@ public:
                 bitPos--;
             } while (decodedSize < originalFileSize);
         }
-
-        auto endTime = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(endTime - startTime);
-        
-        
+        if (!verifier.failed()) output.flush();
 
         cout << "\n解压缩统计信息：" << endl;
         cout << "----------------------------------------" << endl;
-        cout << "解压耗时: " << fixed << setprecision(6) 
-             << duration.count() / 1000000.0 << " 秒" << endl;
         cout << "已解码大小: " << decodedSize << " 字节" << endl;
         cout << "----------------------------------------" << endl;
 
         inFile.close();
         outFile.close();
-        uint64_t decompressedHash = calculateFileHash(outputPath);
-        cout << "解压文件哈希值: 0x" << hex << uppercase << setfill('0') 
-             << setw(16) << decompressedHash << dec << endl;
-        return true;
+        return reportChecksum(verifier);
     }
 
     //另一种解压方法：
@@ -230,6 +320,7 @@ public:
             cerr << "无法打开压缩文件！" << endl;
             return false;
         }
+        inFile.seekg(payloadOffset);
 
         string outputPath = compressedPath;
         size_t lastDot = outputPath.find_last_of('.');
@@ -244,13 +335,14 @@ public:
             return false;
         }
 
-        auto startTime = high_resolution_clock::now();
+        ChecksumVerifier verifier = makeVerifier();
+        CheckedOutput output(outFile, verifier);
 
         string currentCode;
-        long decodedSize = 0;
+        uint64_t decodedSize = 0;
         char byte;
 
-        while (inFile.get(byte) && decodedSize < originalFileSize) {
+        while (!verifier.failed() && inFile.get(byte) && decodedSize < originalFileSize) {
             unsigned char curByte = static_cast<unsigned char>(byte);
             
             for (int bitPos = 7; bitPos >= 0 && decodedSize < originalFileSize; bitPos--) {
@@ -258,30 +350,68 @@ public:
                 
                 auto it = codeMap.find(currentCode);
                 if (it != codeMap.end()) {
-                    outFile.put(it->second);
+                    if (!output.put(it->second)) break;
                     decodedSize++;
                     currentCode.clear();
                 }
             }
         }
-
-        auto endTime = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(endTime - startTime);
+        if (!verifier.failed()) output.flush();
 
         cout << "\n映射表解压统计信息：" << endl;
         cout << "----------------------------------------" << endl;
-        cout << "解压耗时: " << fixed << setprecision(6) 
-             << duration.count() / 1000000.0 << " 秒" << endl;
         cout << "已解码大小: " << decodedSize << " 字节" << endl;
         cout << "----------------------------------------" << endl;
 
         inFile.close();
         outFile.close();
+        return reportChecksum(verifier);
+    }
 
-        uint64_t decompressedHash = calculateFileHash(outputPath);
-        cout << "解压文件哈希值: 0x" << hex << uppercase << setfill('0') 
-             << setw(16) << decompressedHash << dec << endl;
-        return true;
+    //查找表解压：一次补充64位缓冲，按多位索引连续解码
+    bool decompressWithTable(const string& compressedPath) {
+        ifstream inFile(compressedPath, ios::binary);
+        if (!inFile) {
+            cerr << "无法打开压缩文件！" << endl;
+            return false;
+        }
+        inFile.seekg(payloadOffset);
+
+        string outputPath = compressedPath;
+        size_t lastDot = outputPath.find_last_of('.');
+        if (lastDot != string::npos) {
+            outputPath = outputPath.substr(0, lastDot);
+        }
+        outputPath += "_table_j.txt";
+
+        ofstream outFile(outputPath, ios::binary);
+        if (!outFile) {
+            cerr << "无法创建解压文件！" << endl;
+            return false;
+        }
+
+        ChecksumVerifier verifier = makeVerifier();
+
+        uint64_t decodedSize;
+        if (blockMode) {
+            ThreadPool pool;
+            decodedSize = decodeBlocksParallel(inFile, payloadOffset, outFile, tableDecoder, blockIndex,
+                                               originalFileSize, pool,
+                                               [](unsigned char*, size_t, uint64_t) { return true; },
+                                               [&](const unsigned char* data, size_t n) { verifier.update(data, n); });
+        } else {
+            decodedSize = tableDecoder.decode(inFile, outFile, originalFileSize,
+                [&](unsigned char* data, size_t n) { return verifier.update(data, n); });
+        }
+
+        cout << "\n查找表解压统计信息：" << endl;
+        cout << "----------------------------------------" << endl;
+        cout << "已解码大小: " << decodedSize << " 字节" << endl;
+        cout << "----------------------------------------" << endl;
+
+        inFile.close();
+        outFile.close();
+        return reportChecksum(verifier);
     }
 
 };
@@ -293,13 +423,34 @@ int main() {
     cout << "请输入压缩文件路径(.hfm): ";
     getline(cin, compressedFile);
 
-    // 加载编码表并解压
-    if (!decompressor.loadCodeTable("code.txt") || 
-        !decompressor.decompress(compressedFile)) {
+    // 自描述容器直接从文件头部加载编码表，否则读取 code.txt
+    ifstream probe(compressedFile, ios::binary);
+    if (probe && isHfaArchive(probe)) {
+        cerr << "该文件是批量归档，请使用 decompression_text 解压！" << endl;
         return 1;
     }
-    // 使用编码映射表解压
-    if (!decompressor.decompressWithMap(compressedFile)) {
+    bool container = probe && isHfmContainer(probe);
+    probe.close();
+    bool loaded = container ? decompressor.loadContainer(compressedFile)
+                            : decompressor.loadCodeTable("code.txt");
+
+    if (!loaded) {
+        return 1;
+    }
+    // 各解码方式的速度由 huffman_benchmark 在内存中比较（不含文件读写），这里只解压并校验。
+    // 分块格式的块间有填充位，逐位解码树和映射表无法跨块，只用查找表解压
+    if (!decompressor.isBlockMode()) {
+        // 解码树解压
+        if (!decompressor.decompress(compressedFile)) {
+            return 1;
+        }
+        // 使用编码映射表解压
+        if (!decompressor.decompressWithMap(compressedFile)) {
+            return 1;
+        }
+    }
+    // 使用多级查找表解压
+    if (!decompressor.decompressWithTable(compressedFile)) {
         return 1;
     }
     return 0;
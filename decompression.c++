@@ -5,8 +5,11 @@
 #include <map>
 #include<chrono> //添加计时器
 #include <iomanip>
-#define FNV1A_64_INIT 0xcbf29ce484222325ULL
-#define FNV1A_64_PRIME 0x100000001b3
+#include "huffman_table_decoder.h"
+#include "huffman_checksum.h"
+#include "huffman_container.h"
+#include "huffman_parallel.h"
+#include "huffman_archive.h"
 using namespace std;
 using namespace chrono; //使用chrono命名空间
 // 定义解码树节点结构
@@ -23,17 +26,13 @@ struct DecodeNode {
 class HuffmanDecompression {
 private:
     DecodeNode* root;      // 解码树根节点
+    HuffmanTableDecoder tableDecoder;  // 查找表解码器
+    bool isContainer = false;          // 是否为自描述容器格式
+    HfmHeader containerHeader;
+    HfmBlockIndex blockIndex;          // 分块格式的块索引
+    HfmChecksumIndex checksumIndex;    // 块校验表，unit 为0表示没有
+    streamoff payloadOffset = 0;       // 容器格式位流的起始位置
 
-    //添加FNV-1a哈希计算函数
-    uint64_t fnv1a_64(const void *data, size_t length) {
-        uint64_t hash = FNV1A_64_INIT;
-        const uint8_t *byte_data = (const uint8_t *)data;
-        for (size_t i = 0; i < length; i++) {
-            hash ^= byte_data[i];
-            hash *= FNV1A_64_PRIME;
-        }
-        return hash;
-    }
     //计算文件的hash值
     uint64_t calculateFileHash(const string& filename) {
         ifstream file(filename, ios::binary);
@@ -42,18 +41,14 @@ private:
             return 0;
         }
 
-        // 获取文件大小
-        file.seekg(0, ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, ios::beg);
-
-        // 读取文件内容
-        vector<uint8_t> buffer(fileSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-        file.close();
-
-        // 计算哈希值
-        return fnv1a_64(buffer.data(), fileSize);
+        // 分块读取并增量计算哈希值，内存占用与文件大小无关
+        vector<uint8_t> buffer(1 << 16);
+        uint64_t hash = FNV64_OFFSET_BASIS;
+        while (file) {
+            file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+            hash = fnv1a64Update(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+        return hash;
     }
 
     // 从编码表构建解码树
@@ -114,6 +109,7 @@ public:
         codeFile.seekg(4);
 
         // 读取编码表
+        vector<pair<unsigned char, CodeWord>> codeWords;
         while (codeFile.peek() != EOF) {
             unsigned char byte, codeLength;
             
@@ -146,9 +142,60 @@ public:
     
             // 构建解码树
             buildDecodeTree(byte, code);
+
+            CodeWord word;
+            if (!codeStringToWord(code, word)) {
+                cerr << "编码长度超过64位！" << endl;
+                return false;
+            }
+            codeWords.emplace_back(byte, word);
         }
     
         codeFile.close();
+        // 构建查找表
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 从自描述容器头部加载编码表
+    bool loadContainer(const string& compressedPath) {
+        ifstream inFile(compressedPath, ios::binary);
+        if (!inFile || !readHfmHeader(inFile, containerHeader)) {
+            cerr << "无法读取压缩文件头部或头部已损坏！" << endl;
+            return false;
+        }
+        if (containerHeader.flags & HFM_FLAG_SYMBOLS) {
+            cerr << "该文件使用多字节符号模式，请使用 decompression_text 解压！" << endl;
+            return false;
+        }
+        if ((containerHeader.flags & HFM_FLAG_BLOCKS) &&
+            !readBlockIndex(inFile, containerHeader, blockIndex, streamBytesLeft(inFile))) {
+            cerr << "块索引已损坏！" << endl;
+            return false;
+        }
+        HfmSyncIndex syncIndex;
+        if ((containerHeader.flags & HFM_FLAG_SYNC_POINTS) && !readSyncIndex(inFile, containerHeader, syncIndex)) {
+            cerr << "同步点索引已损坏！" << endl;
+            return false;
+        }
+        if ((containerHeader.flags & HFM_FLAG_BLOCK_CHECKSUMS) &&
+            !readChecksumIndex(inFile, containerHeader, checksumIndex)) {
+            cerr << "块校验表已损坏！" << endl;
+            return false;
+        }
+        payloadOffset = inFile.tellg();
+        vector<pair<unsigned char, CodeWord>> codeWords = codeListFromLengths(containerHeader.codeLengths);
+        for (const auto& pair : codeWords) {
+            buildDecodeTree(pair.first, codeWordToString(pair.second));
+        }
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        isContainer = true;
         return true;
     }
 
@@ -160,9 +207,16 @@ public:
             return false;
         }
 
-        // 读取原文件大小
-        long originalSize;
-        inFile.read(reinterpret_cast<char*>(&originalSize), sizeof(originalSize));
+        // 读取原文件大小：容器格式取自头部，旧格式位于文件开头
+        uint64_t originalSize;
+        if (isContainer) {
+            originalSize = containerHeader.originalSize;
+            inFile.seekg(payloadOffset);
+        } else {
+            int64_t storedSize = 0;
+            inFile.read(reinterpret_cast<char*>(&storedSize), sizeof(storedSize));
+            originalSize = static_cast<uint64_t>(storedSize);
+        }
 
         // 构造输出文件名
         string outputPath = compressedPath;
@@ -177,32 +231,24 @@ public:
             cerr << "无法创建解压文件！" << endl;
             return false;
         }
+        // 解码结果在写出前送入校验，旧格式没有记录校验值，只计算 FNV-1a 供显示
+        HfmHeader legacyHeader;
+        legacyHeader.originalSize = originalSize;
+        ChecksumVerifier verifier(isContainer ? containerHeader : legacyHeader, &checksumIndex);
         //开始计时
         auto startTime = high_resolution_clock::now();
-        // 解码并写入文件
-        DecodeNode* current = root;
-        long decodedSize = 0;
-        char byte;
-        
-        while (inFile.get(byte) && decodedSize < originalSize) {
-            string binStr = byteToBinaryString(static_cast<unsigned char>(byte));
-            
-            for (char bit : binStr) {
-                if (decodedSize >= originalSize) break;
-                
-                if (!current) {
-                    cerr << "解码树错误！" << endl;
-                    return false;
-                }
-
-                current = (bit == '0') ? current->left : current->right;
-                
-                if (current && current->isLeaf) {
-                    outFile.put(current->byte);
-                    decodedSize++;
-                    current = root;
-                }
-            }
+        // 查表解码并写入文件
+        uint64_t decodedSize;
+        if (isContainer && (containerHeader.flags & HFM_FLAG_BLOCKS)) {
+            // 分块格式：多线程按块解码，写出时按顺序校验
+            ThreadPool pool;
+            decodedSize = decodeBlocksParallel(inFile, payloadOffset, outFile, tableDecoder, blockIndex,
+                                               originalSize, pool,
+                                               [](unsigned char*, size_t, uint64_t) { return true; },
+                                               [&](const unsigned char* data, size_t n) { verifier.update(data, n); });
+        } else {
+            decodedSize = tableDecoder.decode(inFile, outFile, originalSize,
+                [&](unsigned char* data, size_t n) { return verifier.update(data, n); });
         }
 
         inFile.close();
@@ -211,17 +257,27 @@ public:
         auto endTime = high_resolution_clock::now();
         auto durationMilli = duration_cast<milliseconds>(endTime - startTime);
         auto durationMicro = duration_cast<microseconds>(endTime - startTime);
-        // 计算解压后文件的哈希值
-        uint64_t decompressedHash = calculateFileHash(outputPath);
-
         
         // 在解压函数中添加调试输出
         cout << "原文件大小: " << originalSize << " 字节" << endl;
         cout << "已解码大小: " << decodedSize << " 字节" << endl;
         cout << "解压耗时: " << durationMilli.count() << " 毫秒" << endl;
         cout << "       : "<<durationMicro.count()<<" 微秒"<<endl;
-        cout << "解压文件哈希值: 0x" << hex << uppercase << setfill('0') 
-             << setw(16) << decompressedHash << dec << endl;
+        cout << "解压文件哈希值: " << formatChecksum(verifier.algorithm(), verifier.value()) << endl;
+        if (!isContainer) {
+            cout << "解压完成！文件已保存为：" << outputPath << endl;
+            return true;
+        }
+        // 容器格式记录了校验值：块校验在解码过程中比对，出错时已停止
+        if (verifier.failed()) {
+            cerr << "块校验失败！第 " << verifier.failedBlock() << " 个校验单元（原始数据偏移 "
+                 << verifier.failedOffset() << " 起）已损坏，已停止解压" << endl;
+            return false;
+        }
+        if (!verifier.finish()) {
+            cerr << "校验失败！期望哈希值: " << formatChecksum(verifier.algorithm(), verifier.expectedValue()) << endl;
+            return false;
+        }
         cout << "解压完成！文件已保存为：" << outputPath << endl;
         return true;
     }
@@ -242,8 +298,17 @@ int main() {
     // 构造编码表文件路径
     string codeTableFile = "code_bin.txt";
 
-    // 加载编码表并构建解码树
-    if (!decompressor.loadCodeTable(codeTableFile)) {
+    // 自描述容器直接从文件头部加载编码表，否则读取 code_bin.txt
+    ifstream probe(compressedFile, ios::binary);
+    if (probe && isHfaArchive(probe)) {
+        cerr << "该文件是批量归档，请使用 decompression_text 解压！" << endl;
+        return 1;
+    }
+    bool container = probe && isHfmContainer(probe);
+    probe.close();
+    bool loaded = container ? decompressor.loadContainer(compressedFile)
+                            : decompressor.loadCodeTable(codeTableFile);
+    if (!loaded) {
         return 1;
     }
 
@@ -6,8 +6,16 @@
 #include <map>
 #include <chrono>
 #include <iomanip>
-#define FNV1A_64_INIT 0xcbf29ce484222325ULL
-#define FNV1A_64_PRIME 0x100000001b3
+#include "huffman_table_decoder.h"
+#include "huffman_checksum.h"
+#include "huffman_container.h"
+#include "huffman_parallel.h"
+#include "huffman_stream.h"
+#include "huffman_symbols.h"
+#include "huffman_archive.h"
+#include <filesystem>
+#include <cerrno>
+#include <cstdlib>
 using namespace std;
 using namespace chrono;
 // 用户信息
@@ -33,11 +41,33 @@ enum class EncryptionType {
     XOR_KEY
 };
 const string DEFAULT_KEY = "HuffmanSecretKey2024";  // 可以根据需要修改默认密钥
+
+// 解析交互输入的偏移、长度或序号：只接受不超过64位的十进制非负整数
+bool parseByteCount(const string& text, uint64_t& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != string::npos) return false;
+    errno = 0;
+    value = strtoull(text.c_str(), nullptr, 10);
+    return errno != ERANGE;
+}
 class HuffmanDecompression {
 private:
     DecodeNode* root;
-    long originalFileSize;
+    HuffmanTableDecoder tableDecoder;  // 表驱动解码器，用于正文解码
+    uint64_t originalFileSize;
     UserInfo userInfo;
+    bool isContainer = false;      // 是否为自描述容器格式
+    HfmHeader containerHeader;
+    HfmBlockIndex blockIndex;      // 分块模式的块索引
+    HfmSyncIndex syncIndex;        // 同步点索引，用于按范围提取
+    HfmSymbolTable symbolTable;    // 多字节符号模式的符号表
+    HfmChecksumIndex checksumIndex;  // 块校验表，unit 为0表示没有
+    streamoff payloadOffset = 0;   // 位流在压缩文件中的起始位置
+    unsigned threadCount = 0;      // 分块解压线程数，0 表示全部CPU核心
+    // 批量归档
+    string archivePath;
+    HfaHeader archiveHeader;
+    vector<HfaEntry> archiveEntries;  // 第0项为用户信息头部
+    HfaSharedTable archiveShared;
     static const uint8_t OFFSET_VALUE = 0x55;
     static const int ID_LENGTH = 10;        // 学号固定长度
     static const int MAX_NAME_LENGTH = 20;  // 姓名最大长度
@@ -91,35 +121,140 @@ private:
         return false;
     }
 
-    uint64_t fnv1a_64(const void *data, size_t length) {
-        uint64_t hash = FNV1A_64_INIT;
-        const uint8_t *byte_data = (const uint8_t *)data;
-        for (size_t i = 0; i < length; i++) {
-            hash ^= byte_data[i];
-            hash *= FNV1A_64_PRIME;
+    // 按块解密（与逐字节 decryptByte 结果一致），keyIndex 为首字节对应的密钥下标
+    void decryptRange(unsigned char* data, size_t n, EncryptionType encType, const string& key, uint64_t keyIndex) {
+        if (encType == EncryptionType::OFFSET) {
+            for (size_t i = 0; i < n; i++) data[i] -= OFFSET_VALUE;
+        } else if (encType == EncryptionType::XOR_KEY) {
+            size_t index = static_cast<size_t>(keyIndex % key.length());
+            for (size_t i = 0; i < n; i++) {
+                data[i] ^= key[index];
+                if (++index == key.length()) index = 0;
+            }
         }
-        return hash;
     }
-    //计算文件的hash值
-    uint64_t calculateFileHash(const string& filename) {
-        ifstream file(filename, ios::binary);
-        if (!file) {
-            cerr << "无法打开文件进行哈希计算：" << filename << endl;
-            return 0;
+
+    // 容器格式头部记录了用户信息长度：从 reader 当前位置查表解码这一段并验证，
+    // 解密后的头部存入 header，reader 停在正文起点
+    bool readContainerUserInfo(BitReader& reader, EncryptionType encType, const string& key,
+                               vector<unsigned char>& header) {
+        if (containerHeader.userInfoLength > originalFileSize) return false;
+        // 多字节符号不跨越头部末尾，解码结果恰好是头部长度
+        size_t length = containerHeader.userInfoLength;
+        header.resize(length + HuffmanTableDecoder::MAX_SYMBOL_BYTES - 1);
+        if (tableDecoder.decodeBytes(reader, header.data(), length) != length) {
+            return false;
         }
+        header.resize(length);
+        decryptRange(header.data(), header.size(), encType, key, 0);
+        return parseUserInfo(string(header.begin(), header.end()));
+    }
+
+    // 从位流第 startBit 位开始解码，丢弃前 skip 个字节后取 n 个字节写入 dst。
+    // 多字节符号可能跨越第 skip 个字节，按解码出的字节位置截取
+    bool decodeFrom(ifstream& inFile, uint64_t startBit, uint64_t skip, unsigned char* dst, size_t n) {
+        inFile.clear();
+        inFile.seekg(payloadOffset + static_cast<streamoff>(startBit / 8));
+        BitReader reader(inFile);
+        reader.skipBits(static_cast<int>(startBit % 8));
+        const size_t chunk = 1 << 16;
+        vector<unsigned char> scratch(chunk + HuffmanTableDecoder::MAX_SYMBOL_BYTES - 1);
+        uint64_t end = skip + n;
+        uint64_t position = 0;
+        while (position < end) {
+            size_t want = static_cast<size_t>(min<uint64_t>(chunk, end - position));
+            size_t got = tableDecoder.decodeBytes(reader, scratch.data(), want);
+            if (got < want) return false;
+            uint64_t from = max(position, skip);
+            uint64_t to = min(position + got, end);
+            if (from < to) {
+                memcpy(dst + (from - skip), scratch.data() + (from - position), static_cast<size_t>(to - from));
+            }
+            position += got;
+        }
+        return true;
+    }
+
+    // 按范围提取时可逐单元校验的单元大小：校验单元与块或同步间隔一致时，
+    // 每次解码都从单元起点开始，解完整个单元即可比对；否则返回0，不做块校验
+    uint64_t rangeChecksumUnit() const {
+        if (checksumIndex.unit == 0) return 0;
+        if (isBlockMode()) return checksumIndex.unit == blockIndex.blockSize ? checksumIndex.unit : 0;
+        if (!syncIndex.points.empty()) return checksumIndex.unit == syncIndex.interval ? checksumIndex.unit : 0;
+        return 0;
+    }
+
+    // 读取一条归档记录的压缩数据
+    bool readArchiveRecord(ifstream& inFile, const HfaEntry& entry, vector<unsigned char>& record) {
+        record.resize(static_cast<size_t>(entry.length));
+        inFile.clear();
+        inFile.seekg(static_cast<streamoff>(entry.offset));
+        inFile.read(reinterpret_cast<char*>(record.data()), static_cast<streamsize>(record.size()));
+        return inFile.gcount() == static_cast<streamsize>(record.size());
+    }
+
+    // 解码、解密一条归档记录并比对 CRC32C，各线程可以同时调用
+    bool decodeArchiveMember(const HfaEntry& entry, const vector<unsigned char>& record, vector<unsigned char>& out,
+                             EncryptionType encType, const string& key) {
+        if (!decodeArchiveRecord(record.data(), record.size(), entry, archiveShared, out)) return false;
+        decryptRange(out.data(), out.size(), encType, key, 0);
+        return crc32cUpdate(0, out.data(), out.size()) == entry.crc;
+    }
+
+    // 解码归档中的用户信息头部并验证接收者身份
+    bool verifyArchiveUserInfo(ifstream& inFile, EncryptionType encType, const string& key) {
+        vector<unsigned char> record;
+        vector<unsigned char> header;
+        if (!readArchiveRecord(inFile, archiveEntries[0], record) ||
+            !decodeArchiveMember(archiveEntries[0], record, header, encType, key) ||
+            !parseUserInfo(string(header.begin(), header.end()))) {
+            cerr << "用户信息验证失败！" << endl;
+            return false;
+        }
+        cout << "\n身份验证成功！" << endl;
+        cout << "发送方信息：" << userInfo.senderID << " - " << userInfo.senderName << endl;
+        cout << "接收方信息：" << userInfo.receiverID << " - " << userInfo.receiverName << endl;
+        return true;
+    }
 
-        // 获取文件大小
-        file.seekg(0, ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, ios::beg);
+    // 成员解压到与归档同名的 _j 目录下，如 docs.hfa 的成员 a/b.txt 解压为 docs_j/a/b.txt
+    string archiveOutputPath(const string& name) {
+        string directory = archivePath.substr(0, archivePath.find_last_of('.')) + "_j";
+        return (filesystem::path(directory) / filesystem::path(name)).string();
+    }
 
-        // 读取文件内容
-        vector<uint8_t> buffer(fileSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-        file.close();
+    bool writeArchiveMember(const HfaEntry& entry, const vector<unsigned char>& data) {
+        string outputPath = archiveOutputPath(entry.name);
+        error_code ec;
+        filesystem::create_directories(filesystem::path(outputPath).parent_path(), ec);
+        ofstream outFile(outputPath, ios::binary);
+        outFile.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+        if (!outFile) {
+            cerr << "无法写入解压文件：" << outputPath << endl;
+            return false;
+        }
+        return true;
+    }
 
-        // 计算哈希值
-        return fnv1a_64(buffer.data(), fileSize);
+    // 解压结束后报告整个文件的校验值并与头部比对；块校验失败时指出第一个损坏的单元
+    bool reportChecksum(ChecksumVerifier& verifier, uint64_t decodedSize) {
+        bool ok = verifier.finish();
+        if (verifier.failed()) {
+            cerr << "块校验失败！第 " << verifier.failedBlock() << " 个校验单元（原始数据偏移 "
+                 << verifier.failedOffset() << " 起）已损坏，已停止解压" << endl;
+            return false;
+        }
+        cout << "解压数据哈希值（" << checksumName(verifier.algorithm()) << "）: "
+             << formatChecksum(verifier.algorithm(), verifier.value()) << endl;
+        if (decodedSize != originalFileSize) {
+            cerr << "压缩数据被截断或已损坏！" << endl;
+            return false;
+        }
+        if (!ok) {
+            cerr << "校验失败！期望哈希值: " << formatChecksum(verifier.algorithm(), verifier.expectedValue()) << endl;
+            return false;
+        }
+        return true;
     }
 
     // 将十六进制字符串转换为整数
@@ -312,14 +447,17 @@ public:
             return false;
         }
 
+        isContainer = false;
+        payloadOffset = 0;
         // 读取文件大小
         string fileSizeStr;
         getline(codeFile, fileSizeStr);
-        originalFileSize = stol(fileSizeStr);
+        originalFileSize = stoull(fileSizeStr);
         cout << "原文件大小: " << originalFileSize << " 字节" << endl;
 
         // 读取编码表
         string line;
+        vector<pair<unsigned char, CodeWord>> codeWords;
         while (getline(codeFile, line)) {
             if (line.empty()) continue;
 
@@ -341,12 +479,401 @@ public:
             // 确保编码长度正确
             code = code.substr(0, length);
             buildDecodeTree(byte, code);
+
+            CodeWord word;
+            if (!codeStringToWord(code, word)) {
+                cerr << "编码长度超过64位！" << endl;
+                return false;
+            }
+            codeWords.emplace_back(byte, word);
         }
 
         codeFile.close();
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 从自描述容器头部加载编码表，无需 code.txt
+    bool loadContainer(const string& compressedPath) {
+        ifstream inFile(compressedPath, ios::binary);
+        if (!inFile || !readHfmHeader(inFile, containerHeader)) {
+            cerr << "无法读取压缩文件头部或头部已损坏！" << endl;
+            return false;
+        }
+        isContainer = true;
+        originalFileSize = containerHeader.originalSize;
+        cout << "原文件大小: " << originalFileSize << " 字节" << endl;
+        payloadOffset = static_cast<streamoff>(HFM_HEADER_SIZE);
+        if (isBlockMode()) {
+            if (!readBlockIndex(inFile, containerHeader, blockIndex, streamBytesLeft(inFile))) {
+                cerr << "块索引已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(blockIndex.byteSize());
+            cout << "分块格式：" << blockIndex.blockCount() << " 块，块大小 "
+                 << blockIndex.blockSize << " 字节" << endl;
+        }
+        syncIndex = HfmSyncIndex();
+        if (containerHeader.flags & HFM_FLAG_SYNC_POINTS) {
+            if (!readSyncIndex(inFile, containerHeader, syncIndex)) {
+                cerr << "同步点索引已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(syncIndex.byteSize());
+            cout << "同步点索引：" << syncIndex.points.size() << " 个同步点，间隔 "
+                 << syncIndex.interval << " 字节" << endl;
+        }
+        checksumIndex = HfmChecksumIndex();
+        if (containerHeader.flags & HFM_FLAG_BLOCK_CHECKSUMS) {
+            if (!readChecksumIndex(inFile, containerHeader, checksumIndex)) {
+                cerr << "块校验表已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(checksumIndex.byteSize());
+            cout << "块校验表：" << checksumIndex.checksums.size() << " 个校验单元，每个 "
+                 << checksumIndex.unit << " 字节" << endl;
+        }
+        cout << "校验算法：" << checksumName(containerHeader.checksum) << endl;
+        symbolTable = HfmSymbolTable();
+        if (containerHeader.flags & HFM_FLAG_SYMBOLS) {
+            // 多字节符号只用表驱动解码器解码，不建立逐位解码树
+            if (isBlockMode()) {
+                cerr << "分块格式不支持多字节符号！" << endl;
+                return false;
+            }
+            if (!readSymbolTable(inFile, containerHeader, symbolTable) ||
+                !buildSymbolDecoder(tableDecoder, containerHeader, symbolTable)) {
+                cerr << "符号表已损坏！" << endl;
+                return false;
+            }
+            payloadOffset += static_cast<streamoff>(symbolTable.byteSize());
+            cout << "多字节符号模式（" << alphabetName(symbolTable.alphabet) << "）："
+                 << symbolTable.keys.size() << " 个多字节符号" << endl;
+            return true;
+        }
+
+        vector<pair<unsigned char, CodeWord>> codeWords = codeListFromLengths(containerHeader.codeLengths);
+        for (const auto& pair : codeWords) {
+            buildDecodeTree(pair.first, codeWordToString(pair.second));
+        }
+        if (!tableDecoder.build(codeWords)) {
+            cerr << "编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 容器中记录的加密方式
+    EncryptionType containerEncryption() const {
+        return static_cast<EncryptionType>(containerHeader.encryption);
+    }
+
+    bool isBlockMode() const {
+        return isContainer && (containerHeader.flags & HFM_FLAG_BLOCKS);
+    }
+
+    void setThreadCount(unsigned threads) {
+        threadCount = threads;
+    }
+
+    // 流式解压：从任意输入流（可以是管道）读取容器，经 HuffmanStreamDecoder 的固定缓冲区
+    // 边解码边解密写出，哈希值增量计算，内存占用与文件大小无关。
+    // 用户信息头部解码完成并通过身份验证之前不写出任何数据，块校验失败的数据也不写出
+    bool decompressStream(istream& in, ostream& out, EncryptionType encType = EncryptionType::NONE,
+                          const string& key = DEFAULT_KEY) {
+        uint32_t blockSize = 0;
+        checksumIndex = HfmChecksumIndex();
+        if (!readHfmHeader(in, containerHeader) ||
+            !skipHfmIndexes(in, containerHeader, blockSize, &checksumIndex)) {
+            cerr << "无法读取压缩文件头部或头部已损坏！" << endl;
+            return false;
+        }
+        if (containerHeader.flags & HFM_FLAG_SYMBOLS) {
+            cerr << "流式解压暂不支持多字节符号模式，请使用完整解压！" << endl;
+            return false;
+        }
+        isContainer = true;
+        originalFileSize = containerHeader.originalSize;
+
+        auto startTime = high_resolution_clock::now();
+        HuffmanStreamDecoder decoder(containerHeader.codeLengths, originalFileSize, blockSize);
+        vector<unsigned char> input(1 << 16);
+        vector<unsigned char> output(1 << 16);
+        size_t inputPos = 0;
+        size_t inputEnd = 0;
+        uint64_t position = 0;
+        ChecksumVerifier verifier(containerHeader, &checksumIndex);
+        // 数据在所在校验单元通过后才写到 out
+        VerifiedOutputBuffer verifiedBuffer(out, verifier);
+        ostream verifiedOut(&verifiedBuffer);
+        string held;  // 身份验证通过前暂存的输出
+        bool verified = false;
+
+        while (decoder.ok() && !decoder.done()) {
+            size_t got = decoder.read(output.data(), output.size());
+            if (got == 0) {
+                if (inputPos == inputEnd) {
+                    in.read(reinterpret_cast<char*>(input.data()), input.size());
+                    inputPos = 0;
+                    inputEnd = static_cast<size_t>(in.gcount());
+                    if (inputEnd == 0) {
+                        decoder.finish();
+                        break;
+                    }
+                }
+                size_t accepted = decoder.feed(input.data() + inputPos, inputEnd - inputPos);
+                if (accepted == 0) break;  // 缓冲区已满仍无法解码，数据已损坏
+                inputPos += accepted;
+                continue;
+            }
+            decryptRange(output.data(), got, encType, key, position);
+            if (!verifier.update(output.data(), got)) break;
+            position += got;
+            if (!verified) {
+                held.append(reinterpret_cast<const char*>(output.data()), got);
+                if (held.size() < containerHeader.userInfoLength && position < originalFileSize) continue;
+                if (!parseUserInfo(held.substr(0, containerHeader.userInfoLength))) {
+                    cerr << "用户信息验证失败！" << endl;
+                    return false;
+                }
+                cout << "\n身份验证成功！" << endl;
+                cout << "发送方信息：" << userInfo.senderID << " - " << userInfo.senderName << endl;
+                cout << "接收方信息：" << userInfo.receiverID << " - " << userInfo.receiverName << endl;
+                verified = true;
+                verifiedOut.write(held.data(), held.size());
+                held.clear();
+                continue;
+            }
+            verifiedOut.write(reinterpret_cast<const char*>(output.data()), got);
+        }
+
+        auto duration = duration_cast<microseconds>(high_resolution_clock::now() - startTime);
+        cout << "\n解压缩统计信息：" << endl;
+        cout << "----------------------------------------" << endl;
+        cout << "解压耗时: " << fixed << setprecision(6) << duration.count() / 1000000.0 << " 秒" << endl;
+        cout << "已解码大小: " << position << " 字节" << endl;
+        cout << "----------------------------------------" << endl;
+        if (!verifier.failed() && !verified) {
+            cerr << "压缩数据被截断或已损坏！" << endl;
+            return false;
+        }
+        bool ok = reportChecksum(verifier, position);
+        verifiedBuffer.release();
+        return ok;
+    }
+
+    // 提取原始数据 [offset, offset+length) 的内容（已解密）到 out，超出文件末尾的部分截断。
+    // 有同步点或块索引时从所在区间的起点解码，否则只能从位流开头解码并跳过之前的数据。
+    // 有块校验表时把涉及的校验单元完整解码并校验，多解码的部分不超过一个单元
+    bool extractRange(const string& compressedPath, uint64_t offset, uint64_t length, vector<unsigned char>& out,
+                      EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY) {
+        out.clear();
+        if (!isContainer) {
+            cerr << "只有自描述容器格式支持按范围提取！" << endl;
+            return false;
+        }
+        ifstream inFile(compressedPath, ios::binary);
+        if (!inFile) {
+            cerr << "无法打开压缩文件！" << endl;
+            return false;
+        }
+        // 与完整解压相同，先验证接收者身份
+        inFile.seekg(payloadOffset);
+        BitReader headerReader(inFile);
+        vector<unsigned char> headerBytes;
+        if (!readContainerUserInfo(headerReader, encType, key, headerBytes)) {
+            cerr << "用户信息验证失败！" << endl;
+            return false;
+        }
+        if (offset >= originalFileSize) return true;
+        length = min(length, originalFileSize - offset);
+        out.resize(static_cast<size_t>(length));
+
+        const uint64_t unit = rangeChecksumUnit();
+        vector<unsigned char> unitData;
+        uint64_t done = 0;
+        while (done < length) {
+            uint64_t position = offset + done;
+            uint64_t startBit = 0;       // 解码起点在位流中的位置
+            uint64_t startPos = 0;       // 解码起点对应的原始数据位置
+            uint64_t endPos = originalFileSize;  // 本次可连续解码到的位置
+            uint64_t keyIndex = 0;       // 解码起点对应的密钥下标
+            if (isBlockMode()) {
+                // 各块从字节边界开始，跨块时逐块解码
+                size_t b = static_cast<size_t>(position / blockIndex.blockSize);
+                startBit = blockIndex.bitOffsets[b];
+                startPos = static_cast<uint64_t>(b) * blockIndex.blockSize;
+                endPos = min(originalFileSize, startPos + blockIndex.blockSize);
+                keyIndex = startPos;
+            } else if (!syncIndex.points.empty()) {
+                size_t i = static_cast<size_t>(position / syncIndex.interval);
+                startBit = syncIndex.points[i].bitOffset;
+                startPos = static_cast<uint64_t>(i) * syncIndex.interval;
+                keyIndex = syncIndex.points[i].keyIndex;
+            }
+            size_t want = static_cast<size_t>(min(length - done, endPos - position));
+            if (unit) {
+                // 此时 startPos 即校验单元起点：解码整个单元，校验后再截取
+                size_t i = static_cast<size_t>(startPos / unit);
+                size_t unitLength = static_cast<size_t>(min(unit, originalFileSize - startPos));
+                want = static_cast<size_t>(min<uint64_t>(want, startPos + unitLength - position));
+                unitData.resize(unitLength);
+                if (!decodeFrom(inFile, startBit, 0, unitData.data(), unitLength)) {
+                    cerr << "压缩数据已损坏，无法解码指定范围！" << endl;
+                    out.resize(static_cast<size_t>(done));
+                    return false;
+                }
+                decryptRange(unitData.data(), unitLength, encType, key, keyIndex);
+                if (!checkBlockChecksum(checksumIndex, i, unitData.data(), unitLength)) {
+                    cerr << "块校验失败！第 " << i << " 个校验单元（原始数据偏移 " << startPos
+                         << " 起）已损坏" << endl;
+                    out.resize(static_cast<size_t>(done));
+                    return false;
+                }
+                memcpy(out.data() + done, unitData.data() + (position - startPos), want);
+                done += want;
+                continue;
+            }
+            if (!decodeFrom(inFile, startBit, position - startPos, out.data() + done, want)) {
+                cerr << "压缩数据已损坏，无法解码指定范围！" << endl;
+                out.resize(static_cast<size_t>(done));
+                return false;
+            }
+            decryptRange(out.data() + done, want, encType, key, keyIndex + (position - startPos));
+            done += want;
+        }
+        return true;
+    }
+
+    // 读取批量归档的头部和目录，建立共享编码表的解码器
+    bool loadArchive(const string& path) {
+        ifstream inFile(path, ios::binary);
+        if (!inFile || !readHfaHeader(inFile, archiveHeader) ||
+            !readHfaDirectory(inFile, archiveHeader, archiveEntries)) {
+            cerr << "无法读取归档头部或目录已损坏！" << endl;
+            return false;
+        }
+        archiveShared = HfaSharedTable();
+        if ((archiveHeader.flags & HFA_FLAG_SHARED_TABLE) && !archiveShared.build(archiveHeader.sharedLengths)) {
+            cerr << "共享编码表不是有效的前缀码！" << endl;
+            return false;
+        }
+        archivePath = path;
+        size_t sharedCount = 0;
+        for (size_t i = 1; i < archiveEntries.size(); i++) {
+            if (archiveEntries[i].table == HFA_TABLE_SHARED) sharedCount++;
+        }
+        cout << "批量归档：" << archiveHeader.memberCount << " 个成员";
+        if (archiveShared.present) {
+            cout << "，其中 " << sharedCount << " 个使用共享编码表";
+        } else {
+            cout << "，没有共享编码表";
+        }
+        cout << endl;
+        return true;
+    }
+
+    EncryptionType archiveEncryption() const {
+        return static_cast<EncryptionType>(archiveHeader.encryption);
+    }
+
+    // 列出归档成员：序号、原始大小、压缩后大小、编码表和名称
+    void listArchive() {
+        cout << "序号 原始大小 压缩大小 编码表 名称" << endl;
+        for (size_t i = 1; i < archiveEntries.size(); i++) {
+            const HfaEntry& entry = archiveEntries[i];
+            cout << i << ' ' << entry.originalSize << ' ' << entry.length << ' '
+                 << (entry.table == HFA_TABLE_SHARED ? "共享" : "私有") << ' ' << entry.name << endl;
+        }
+    }
+
+    // 只解压一个成员：按名称或序号（从1开始）查找目录，只读取该成员的记录
+    bool extractArchiveMember(const string& selector, EncryptionType encType = EncryptionType::NONE,
+                              const string& key = DEFAULT_KEY) {
+        size_t index = 0;
+        for (size_t i = 1; i < archiveEntries.size() && index == 0; i++) {
+            if (archiveEntries[i].name == selector) index = i;
+        }
+        uint64_t number;
+        if (index == 0 && parseByteCount(selector, number) && number < archiveEntries.size()) {
+            index = static_cast<size_t>(number);
+        }
+        if (index == 0 || index >= archiveEntries.size()) {
+            cerr << "归档中没有成员：" << selector << endl;
+            return false;
+        }
+        ifstream inFile(archivePath, ios::binary);
+        if (!inFile || !verifyArchiveUserInfo(inFile, encType, key)) return false;
+
+        auto startTime = high_resolution_clock::now();
+        const HfaEntry& entry = archiveEntries[index];
+        vector<unsigned char> record;
+        vector<unsigned char> data;
+        if (!readArchiveRecord(inFile, entry, record) || !decodeArchiveMember(entry, record, data, encType, key)) {
+            cerr << "成员 " << entry.name << " 已损坏或校验失败！" << endl;
+            return false;
+        }
+        if (!writeArchiveMember(entry, data)) return false;
+        auto duration = duration_cast<microseconds>(high_resolution_clock::now() - startTime);
+        cout << "已解压 " << entry.name << "（" << data.size() << " 字节）到 " << archiveOutputPath(entry.name)
+             << "，耗时 " << fixed << setprecision(6) << duration.count() / 1000000.0 << " 秒" << endl;
         return true;
     }
 
+    // 解压全部成员：每轮按顺序读入若干条记录，由线程池并行解码、解密和校验，再按顺序写出。
+    // 损坏的成员不写出，其余成员照常解压
+    bool extractArchive(EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY) {
+        ifstream inFile(archivePath, ios::binary);
+        if (!inFile || !verifyArchiveUserInfo(inFile, encType, key)) return false;
+
+        auto startTime = high_resolution_clock::now();
+        ThreadPool pool(threadCount);
+        cout << "使用 " << pool.size() << " 个线程并行解码" << endl;
+        const size_t perRound = pool.size() * 8;
+        vector<vector<unsigned char>> records(perRound);
+        vector<vector<unsigned char>> outputs(perRound);
+        vector<char> ok(perRound);
+        size_t failed = 0;
+        uint64_t totalSize = 0;
+        for (size_t first = 1; first < archiveEntries.size(); first += perRound) {
+            size_t count = min(perRound, archiveEntries.size() - first);
+            for (size_t k = 0; k < count; k++) {
+                ok[k] = readArchiveRecord(inFile, archiveEntries[first + k], records[k]);
+            }
+            pool.parallelFor(count, [&](size_t k) {
+                ok[k] = ok[k] && decodeArchiveMember(archiveEntries[first + k], records[k], outputs[k], encType, key);
+            });
+            for (size_t k = 0; k < count; k++) {
+                const HfaEntry& entry = archiveEntries[first + k];
+                if (!ok[k]) {
+                    cerr << "成员 " << entry.name << " 已损坏或校验失败，未解压" << endl;
+                    failed++;
+                    continue;
+                }
+                if (!writeArchiveMember(entry, outputs[k])) {
+                    failed++;
+                    continue;
+                }
+                totalSize += outputs[k].size();
+            }
+        }
+
+        auto duration = duration_cast<microseconds>(high_resolution_clock::now() - startTime);
+        double seconds = duration.count() / 1000000.0;
+        size_t members = archiveEntries.size() - 1;
+        cout << "\n解压缩统计信息：" << endl;
+        cout << "----------------------------------------" << endl;
+        cout << "解压耗时: " << fixed << setprecision(6) << seconds << " 秒" << endl;
+        cout << "已解压成员: " << members - failed << " / " << members << "，共 " << totalSize << " 字节" << endl;
+        cout << "每秒解压文件数: " << setprecision(1) << (seconds > 0 ? members / seconds : 0.0) << endl;
+        cout << "输出目录: " << archivePath.substr(0, archivePath.find_last_of('.')) + "_j" << endl;
+        cout << "----------------------------------------" << endl;
+        return failed == 0;
+    }
+
     // 解压缩文件
     bool decompress(const string& compressedPath, EncryptionType encType = EncryptionType::NONE,
         const string& key = DEFAULT_KEY) {
@@ -355,8 +882,14 @@ public:
             cerr << "无法打开压缩文件！" << endl;
             return false;
         }
-        // 验证用户信息
-        if (!readAndVerifyUserInfo(inFile, root, encType, key)) {
+        // 容器格式的位流从头部（及索引）之后开始
+        inFile.seekg(payloadOffset);
+        // 验证用户信息：容器格式只解码头部一次，正文从同一位置继续
+        BitReader reader(inFile);
+        vector<unsigned char> headerBytes;
+        bool verified = isContainer ? readContainerUserInfo(reader, encType, key, headerBytes)
+                                    : readAndVerifyUserInfo(inFile, root, encType, key);
+        if (!verified) {
             cerr << "用户信息验证失败！" << endl;
             return false;
         }
@@ -364,8 +897,7 @@ public:
         cout << "\n身份验证成功！" << endl;
         cout << "发送方信息：" << userInfo.senderID << " - " << userInfo.senderName << endl;
         cout << "接收方信息：" << userInfo.receiverID << " - " << userInfo.receiverName << endl;
-        
-        inFile.seekg(0);//将文件指针移动到文件开头
+
         string outputPath = compressedPath;
         size_t lastDot = outputPath.find_last_of('.');
         if (lastDot != string::npos) {
@@ -381,36 +913,65 @@ public:
 
         auto startTime = high_resolution_clock::now();
 
-        DecodeNode* current = root;
-        long decodedSize = 0;
-        char byte;
-        unsigned char bitPos = 7;
-        size_t keyIndex = 0;
-        while (inFile.get(byte) && decodedSize < originalFileSize) {
+        // offset 为数据在原文件中的位置，即对应的密钥下标
+        auto decryptBlock = [&](unsigned char* data, size_t n, uint64_t offset) {
+            decryptRange(data, n, encType, key, offset);
+        };
+        // 解密后的数据在写出前送入校验：容器格式按头部记录的算法比对，
+        // 旧格式没有记录校验值，只计算 FNV-1a 供显示
+        HfmHeader legacyHeader;
+        legacyHeader.originalSize = originalFileSize;
+        const HfmChecksumIndex* blockChecksums = checksumIndex.unit ? &checksumIndex : nullptr;
+        // 分块格式的块校验单元与块一致时，各线程解码后直接校验自己的块
+        bool checkInWorkers = isBlockMode() && blockChecksums && checksumIndex.unit == blockIndex.blockSize;
+        ChecksumVerifier verifier(isContainer ? containerHeader : legacyHeader,
+                                  checkInWorkers ? nullptr : blockChecksums);
+        // 逐单元校验时解出的数据在所在单元通过校验后才写入文件
+        VerifiedOutputBuffer verifiedBuffer(outFile, verifier);
+        ostream output(&verifiedBuffer);
 
-            // 如果是加密文件，先解密字节
-            unsigned char curByte = static_cast<unsigned char>(byte);
-            
-            do {
-                bool bit = (curByte >> bitPos) & 1;
-                current = bit ? current->right : current->left;
-                
-                if (current && current->isLeaf) {
-                    char decodedChar = current->byte;
-                    if (encType != EncryptionType::NONE) {
-                    decodedChar = decryptByte(decodedChar,encType, key, keyIndex++);
-                    }
-                    outFile.put(decodedChar);
-                    decodedSize++;
-                    current = root;
-                }
-                
-                if (bitPos == 0) {
-                    bitPos = 7;
-                    break;
-                }
-                bitPos--;
-            } while (decodedSize < originalFileSize);
+        uint64_t decodedSize;
+        if (isBlockMode()) {
+            // 分块格式：各块由线程池并行解码
+            ThreadPool pool(threadCount);
+            cout << "使用 " << pool.size() << " 个线程并行解码" << endl;
+            decodedSize = decodeBlocksParallel(inFile, payloadOffset, output, tableDecoder,
+                                               blockIndex, originalFileSize, pool,
+                [&](unsigned char* data, size_t n, uint64_t offset) {
+                    decryptBlock(data, n, offset);
+                    return !checkInWorkers ||
+                           checkBlockChecksum(checksumIndex, static_cast<size_t>(offset / blockIndex.blockSize),
+                                              data, n);
+                },
+                [&](const unsigned char* data, size_t n) { verifier.update(data, n); });
+            if (checkInWorkers && decodedSize < originalFileSize) {
+                size_t bad = static_cast<size_t>(decodedSize / blockIndex.blockSize);
+                cerr << "第 " << bad << " 块（原始数据偏移 " << static_cast<uint64_t>(bad) * blockIndex.blockSize
+                     << " 起）解码或块校验失败，已停止解压" << endl;
+            }
+        } else if (isContainer) {
+            // 头部已解码，直接写出后接着解码正文
+            verifier.update(headerBytes.data(), headerBytes.size());
+            output.write(reinterpret_cast<const char*>(headerBytes.data()), headerBytes.size());
+            uint64_t position = headerBytes.size();
+            decodedSize = headerBytes.size();
+            decodedSize += tableDecoder.decode(reader, output, originalFileSize - position,
+                [&](unsigned char* data, size_t n) {
+                    decryptBlock(data, n, position);
+                    position += n;
+                    return verifier.update(data, n);
+                });
+        } else {
+            // 旧格式不知道头部长度，回到位流开头重新解码
+            inFile.clear();
+            inFile.seekg(payloadOffset);
+            uint64_t position = 0;
+            decodedSize = tableDecoder.decode(inFile, output, originalFileSize,
+                [&](unsigned char* data, size_t n) {
+                    decryptBlock(data, n, position);
+                    position += n;
+                    return verifier.update(data, n);
+                });
         }
 
         auto endTime = high_resolution_clock::now();
@@ -426,11 +987,24 @@ public:
         cout << "----------------------------------------" << endl;
 
         inFile.close();
+        if (!isContainer) {
+            outFile.close();
+            cout << "解压文件哈希值: 0x" << hex << uppercase << setfill('0')
+                 << setw(16) << verifier.value() << dec << endl;
+            return true;
+        }
+        // 容器格式记录了原始数据的校验值，解码过程中已逐块比对
+        bool ok = reportChecksum(verifier, decodedSize);
+        verifiedBuffer.release();
         outFile.close();
-        uint64_t decompressedHash = calculateFileHash(outputPath);
-        cout << "解压文件哈希值: 0x" << hex << uppercase << setfill('0') 
-             << setw(16) << decompressedHash << dec << endl;
-        return true;
+        // 没有逐单元校验时数据已直接写出，校验失败后截去未经确认的部分
+        uint64_t kept = checkInWorkers ? decodedSize : verifier.verifiedBytes();
+        if (!ok && verifiedBuffer.bytesReleased() > kept) {
+            error_code ec;
+            filesystem::resize_file(outputPath, kept, ec);
+            cerr << "已截去未通过校验的输出，保留前 " << kept << " 字节" << endl;
+        }
+        return ok;
     }
 };
 
@@ -442,6 +1016,130 @@ int main() {
     cout << "请输入压缩文件路径(.hfm): ";
     getline(cin, compressedFile);
 
+    // 自描述容器：编码表和加密方式都记录在文件头部
+    ifstream probe(compressedFile, ios::binary);
+    if (probe && isHfaArchive(probe)) {
+        probe.close();
+        cout << "检测到批量归档" << endl;
+        if (!decompressor.loadArchive(compressedFile)) {
+            return 1;
+        }
+        EncryptionType encType = decompressor.archiveEncryption();
+        string key = DEFAULT_KEY;
+        if (encType == EncryptionType::XOR_KEY) {
+            cout << "归档使用XOR密钥加密，是否使用自定义密钥？(Y/N，默认使用内置密钥): ";
+            string answer;
+            getline(cin, answer);
+            if (!answer.empty() && toupper(answer[0]) == 'Y') {
+                cout << "请输入密钥: ";
+                getline(cin, key);
+            }
+        }
+        cout << "请选择操作：" << endl;
+        cout << "0. 解压全部成员（默认）" << endl;
+        cout << "1. 解压单个成员" << endl;
+        cout << "2. 列出成员" << endl;
+        string operation;
+        getline(cin, operation);
+        if (operation == "2") {
+            decompressor.listArchive();
+            return 0;
+        }
+        if (operation == "1") {
+            cout << "请输入成员名称或序号: ";
+            string selector;
+            getline(cin, selector);
+            return decompressor.extractArchiveMember(selector, encType, key) ? 0 : 1;
+        }
+        cout << "请输入解压线程数（0 表示使用全部CPU核心）: ";
+        string threadInput;
+        getline(cin, threadInput);
+        unsigned threads;
+        if (!parseThreadCount(threadInput, threads)) {
+            cout << "线程数无效，使用全部CPU核心" << endl;
+        }
+        decompressor.setThreadCount(threads);
+        if (!decompressor.extractArchive(encType, key)) {
+            return 1;
+        }
+        cout << "解压成功！" << endl;
+        return 0;
+    }
+    if (probe && isHfmContainer(probe)) {
+        probe.close();
+        cout << "检测到自描述容器格式" << endl;
+        if (!decompressor.loadContainer(compressedFile)) {
+            return 1;
+        }
+        EncryptionType encType = decompressor.containerEncryption();
+        string key = DEFAULT_KEY;
+        if (encType == EncryptionType::XOR_KEY) {
+            cout << "文件使用XOR密钥加密，是否使用自定义密钥？(Y/N，默认使用内置密钥): ";
+            string answer;
+            getline(cin, answer);
+            if (!answer.empty() && toupper(answer[0]) == 'Y') {
+                cout << "请输入密钥: ";
+                getline(cin, key);
+            }
+        }
+        if (decompressor.isBlockMode()) {
+            cout << "请输入解压线程数（0 表示使用全部CPU核心）: ";
+            string threadInput;
+            getline(cin, threadInput);
+            unsigned threads;
+            if (!parseThreadCount(threadInput, threads)) {
+                cout << "线程数无效，使用全部CPU核心" << endl;
+            }
+            decompressor.setThreadCount(threads);
+        }
+        cout << "请选择操作：" << endl;
+        cout << "0. 完整解压（默认）" << endl;
+        cout << "1. 提取指定范围" << endl;
+        cout << "2. 流式解压（固定内存）" << endl;
+        string operation;
+        getline(cin, operation);
+        if (operation == "1") {
+            string offsetInput, lengthInput;
+            cout << "请输入起始偏移（字节，含用户信息头部）: ";
+            getline(cin, offsetInput);
+            cout << "请输入长度（字节）: ";
+            getline(cin, lengthInput);
+            uint64_t offset, length;
+            if (!parseByteCount(offsetInput, offset) || !parseByteCount(lengthInput, length)) {
+                cerr << "起始偏移和长度必须是非负整数！" << endl;
+                return 1;
+            }
+            vector<unsigned char> range;
+            auto startTime = high_resolution_clock::now();
+            if (!decompressor.extractRange(compressedFile, offset, length, range, encType, key)) {
+                return 1;
+            }
+            auto duration = duration_cast<microseconds>(high_resolution_clock::now() - startTime);
+            string outputPath = compressedFile.substr(0, compressedFile.find_last_of('.')) + "_range_j.txt";
+            ofstream rangeFile(outputPath, ios::binary);
+            rangeFile.write(reinterpret_cast<const char*>(range.data()), range.size());
+            cout << "已提取 " << range.size() << " 字节到 " << outputPath << "，耗时 " << fixed
+                 << setprecision(6) << duration.count() / 1000000.0 << " 秒" << endl;
+            return 0;
+        }
+        if (operation == "2") {
+            ifstream source(compressedFile, ios::binary);
+            string outputPath = compressedFile.substr(0, compressedFile.find_last_of('.')) + "_j.txt";
+            ofstream target(outputPath, ios::binary);
+            if (!source || !target || !decompressor.decompressStream(source, target, encType, key)) {
+                return 1;
+            }
+            cout << "解压成功！" << endl;
+            return 0;
+        }
+        if (!decompressor.decompress(compressedFile, encType, key)) {
+            return 1;
+        }
+        cout<<"解压成功！"<<endl;
+        return 0;
+    }
+    probe.close();
+
     cout << "请选择解密方式：" << endl;
     cout << "0. 未加密文件" << endl;
     cout << "1. 偏移加密" << endl;
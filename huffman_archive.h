@@ -0,0 +1,333 @@
+#ifndef HUFFMAN_ARCHIVE_H
+#define HUFFMAN_ARCHIVE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "huffman_bits.h"
+#include "huffman_container.h"
+#include "huffman_model.h"
+#include "huffman_table_decoder.h"
+
+// 批量归档 .hfa：多个小文件共用一个文件头、一份用户信息头部和一张共享编码表，
+// 省去每个文件单独的 288 字节头部和编码表。所有整数均为小端序：
+//   偏移  长度  内容
+//   0     4     魔数 "HFMA"
+//   4     1     版本号
+//   5     1     加密方式（同 .hfm）
+//   6     2     标志位，见 HFA_FLAG_*
+//   8     4     成员数 n
+//   12    8     目录在文件中的偏移
+//   20    256   共享编码表的码长，没有共享编码表时全为0
+//   276   ...   各条记录，第一条为用户信息头部，之后是各成员
+// 目录位于所有记录之后，共 n+1 项，第0项为用户信息头部（名称为空）：
+//   2     名称长度 L
+//   L     名称（相对路径，以 / 分隔）
+//   8     原始长度
+//   8     记录在文件中的偏移
+//   8     记录字节数
+//   4     原始数据（加密前）的 CRC32C
+//   1     编码表，见 HFA_TABLE_*
+// 使用私有编码表的记录以编码表开头：32 字节位图标出出现的字节值，随后按字节值递增
+// 每个出现的字节一个码长；其后是位流。每条记录独立加密（密钥下标从0开始）并独立编码，
+// 按目录即可单独解压任一成员
+const char HFA_MAGIC[4] = {'H', 'F', 'M', 'A'};
+const uint8_t HFA_VERSION = 1;
+const size_t HFA_HEADER_SIZE = 276;
+const uint16_t HFA_FLAG_SHARED_TABLE = 0x0001;
+const uint8_t HFA_TABLE_SHARED = 0;
+const uint8_t HFA_TABLE_PRIVATE = 1;
+const uint64_t HFA_SAMPLE_BYTES = 4 << 20;  // 训练共享编码表时读取的样本数据量
+
+// 编码表文件 .hft：训练得到的共享编码表，以后的批量归档可以直接加载
+//   0     4     魔数 "HFMT"
+//   4     1     版本号
+//   5     3     保留为0
+//   8     256   码长
+const char HFT_MAGIC[4] = {'H', 'F', 'M', 'T'};
+const size_t HFT_FILE_SIZE = 264;
+
+struct HfaHeader {
+    uint8_t version = HFA_VERSION;
+    uint8_t encryption = 0;
+    uint16_t flags = 0;
+    uint32_t memberCount = 0;
+    uint64_t directoryOffset = 0;
+    uint8_t sharedLengths[256] = {};
+};
+
+// 目录项，对应一条记录
+struct HfaEntry {
+    std::string name;
+    uint64_t originalSize = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    uint32_t crc = 0;
+    uint8_t table = HFA_TABLE_PRIVATE;
+};
+
+inline bool writeHfaHeader(std::ostream& out, const HfaHeader& header) {
+    unsigned char buf[HFA_HEADER_SIZE] = {};
+    std::memcpy(buf, HFA_MAGIC, 4);
+    buf[4] = header.version;
+    buf[5] = header.encryption;
+    putLE(buf + 6, header.flags, 2);
+    putLE(buf + 8, header.memberCount, 4);
+    putLE(buf + 12, header.directoryOffset, 8);
+    std::memcpy(buf + 20, header.sharedLengths, 256);
+    out.write(reinterpret_cast<const char*>(buf), HFA_HEADER_SIZE);
+    return static_cast<bool>(out);
+}
+
+// 判断输入流是否以归档魔数开头，不改变读取位置
+inline bool isHfaArchive(std::istream& in) {
+    std::streampos pos = in.tellg();
+    char magic[4] = {};
+    in.read(magic, 4);
+    bool result = in.gcount() == 4 && std::memcmp(magic, HFA_MAGIC, 4) == 0;
+    in.clear();
+    in.seekg(pos);
+    return result;
+}
+
+inline bool readHfaHeader(std::istream& in, HfaHeader& header) {
+    unsigned char buf[HFA_HEADER_SIZE];
+    in.read(reinterpret_cast<char*>(buf), HFA_HEADER_SIZE);
+    if (in.gcount() != static_cast<std::streamsize>(HFA_HEADER_SIZE)) return false;
+    if (std::memcmp(buf, HFA_MAGIC, 4) != 0) return false;
+    header.version = buf[4];
+    if (header.version != HFA_VERSION) return false;
+    header.encryption = buf[5];
+    if (header.encryption > 2) return false;
+    header.flags = static_cast<uint16_t>(getLE(buf + 6, 2));
+    if (header.flags & ~HFA_FLAG_SHARED_TABLE) return false;
+    header.memberCount = static_cast<uint32_t>(getLE(buf + 8, 4));
+    header.directoryOffset = getLE(buf + 12, 8);
+    std::memcpy(header.sharedLengths, buf + 20, 256);
+    CodeWord codes[256];
+    return !(header.flags & HFA_FLAG_SHARED_TABLE) || canonicalCodes(header.sharedLengths, codes);
+}
+
+// 成员名称只能是相对路径，不能含 ".." 或反斜杠，解压时不会写到输出目录之外
+inline bool isSafeMemberName(const std::string& name) {
+    if (name.empty() || name[0] == '/' || name.find('\\') != std::string::npos) return false;
+    if (name.find(':') != std::string::npos) return false;
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find('/', start);
+        if (end == std::string::npos) end = name.size();
+        std::string part = name.substr(start, end - start);
+        if (part.empty() || part == "." || part == "..") return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+inline bool writeHfaDirectory(std::ostream& out, const std::vector<HfaEntry>& entries) {
+    std::vector<unsigned char> buf;
+    for (const HfaEntry& e : entries) {
+        unsigned char fixed[31];
+        putLE(fixed, e.name.size(), 2);
+        buf.insert(buf.end(), fixed, fixed + 2);
+        buf.insert(buf.end(), e.name.begin(), e.name.end());
+        putLE(fixed, e.originalSize, 8);
+        putLE(fixed + 8, e.offset, 8);
+        putLE(fixed + 16, e.length, 8);
+        putLE(fixed + 24, e.crc, 4);
+        fixed[28] = e.table;
+        buf.insert(buf.end(), fixed, fixed + 29);
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return static_cast<bool>(out);
+}
+
+// 读取目录（含第0项用户信息头部），检查每条记录都位于头部和目录之间
+inline bool readHfaDirectory(std::istream& in, const HfaHeader& header, std::vector<HfaEntry>& entries) {
+    entries.clear();
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(header.directoryOffset));
+    if (!in || header.directoryOffset < HFA_HEADER_SIZE) return false;
+    for (uint64_t i = 0; i <= header.memberCount; i++) {
+        unsigned char fixed[29];
+        in.read(reinterpret_cast<char*>(fixed), 2);
+        if (in.gcount() != 2) return false;
+        HfaEntry e;
+        e.name.resize(static_cast<size_t>(getLE(fixed, 2)));
+        in.read(&e.name[0], static_cast<std::streamsize>(e.name.size()));
+        if (in.gcount() != static_cast<std::streamsize>(e.name.size())) return false;
+        in.read(reinterpret_cast<char*>(fixed), 29);
+        if (in.gcount() != 29) return false;
+        e.originalSize = getLE(fixed, 8);
+        e.offset = getLE(fixed + 8, 8);
+        e.length = getLE(fixed + 16, 8);
+        e.crc = static_cast<uint32_t>(getLE(fixed + 24, 4));
+        e.table = fixed[28];
+        if (i == 0 ? !e.name.empty() : !isSafeMemberName(e.name)) return false;
+        if (e.table > HFA_TABLE_PRIVATE) return false;
+        if (e.table == HFA_TABLE_SHARED && !(header.flags & HFA_FLAG_SHARED_TABLE)) return false;
+        if (e.offset < HFA_HEADER_SIZE || e.length > header.directoryOffset - HFA_HEADER_SIZE ||
+            e.offset > header.directoryOffset - e.length) {
+            return false;
+        }
+        entries.push_back(e);
+    }
+    return true;
+}
+
+inline bool writeCodeTableFile(const std::string& path, const uint8_t lengths[256]) {
+    std::ofstream out(path, std::ios::binary);
+    unsigned char buf[HFT_FILE_SIZE] = {};
+    std::memcpy(buf, HFT_MAGIC, 4);
+    buf[4] = 1;
+    std::memcpy(buf + 8, lengths, 256);
+    out.write(reinterpret_cast<const char*>(buf), HFT_FILE_SIZE);
+    return static_cast<bool>(out);
+}
+
+// 读取共享编码表：可以是 .hft 编码表文件，也可以是单字节模式的 .hfm 容器或带共享编码表的 .hfa 归档
+inline bool readCodeTableFile(const std::string& path, uint8_t lengths[256]) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    CodeWord codes[256];
+    if (isHfmContainer(in)) {
+        HfmHeader header;
+        if (!readHfmHeader(in, header) || (header.flags & HFM_FLAG_SYMBOLS)) return false;
+        std::memcpy(lengths, header.codeLengths, 256);
+        return true;
+    }
+    if (isHfaArchive(in)) {
+        HfaHeader header;
+        if (!readHfaHeader(in, header) || !(header.flags & HFA_FLAG_SHARED_TABLE)) return false;
+        std::memcpy(lengths, header.sharedLengths, 256);
+        return true;
+    }
+    unsigned char buf[HFT_FILE_SIZE];
+    in.read(reinterpret_cast<char*>(buf), HFT_FILE_SIZE);
+    if (in.gcount() != static_cast<std::streamsize>(HFT_FILE_SIZE)) return false;
+    if (std::memcmp(buf, HFT_MAGIC, 4) != 0 || buf[4] != 1) return false;
+    std::memcpy(lengths, buf + 8, 256);
+    return canonicalCodes(lengths, codes);
+}
+
+// 由词频求码长，超过 maxLength 时改用受限码长；无法限制在 maxLength 以内时限制在容器允许的最大码长
+inline void archiveCodeLengths(const uint64_t counts[256], int maxLength, uint8_t lengths[256]) {
+    if (huffmanCodeLengths(counts, 256, lengths) <= maxLength) return;
+    if (!limitedCodeLengths(counts, maxLength, lengths)) limitedCodeLengths(counts, HFM_MAX_CODE_LENGTH, lengths);
+}
+
+// 由样本词频训练共享编码表：每个字节值的计数加1，样本中没有出现的字节也有编码，
+// 任何成员都能用共享编码表编码
+inline void trainSharedLengths(const uint64_t sampleCounts[256], int maxLength, uint8_t lengths[256]) {
+    uint64_t counts[256];
+    for (int b = 0; b < 256; b++) counts[b] = sampleCounts[b] + 1;
+    archiveCodeLengths(counts, maxLength, lengths);
+}
+
+// 私有编码表在记录中占用的字节数
+inline size_t privateTableSize(const uint8_t lengths[256]) {
+    size_t size = 32;
+    for (int b = 0; b < 256; b++) size += lengths[b] ? 1 : 0;
+    return size;
+}
+
+inline void appendPrivateTable(std::vector<unsigned char>& out, const uint8_t lengths[256]) {
+    unsigned char bitmap[32] = {};
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b]) bitmap[b >> 3] |= static_cast<unsigned char>(1 << (b & 7));
+    }
+    out.insert(out.end(), bitmap, bitmap + 32);
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b]) out.push_back(lengths[b]);
+    }
+}
+
+// 读取记录开头的私有编码表，返回占用的字节数，表损坏时返回0
+inline size_t readPrivateTable(const unsigned char* data, size_t length, uint8_t lengths[256]) {
+    if (length < 32) return 0;
+    size_t used = 32;
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+        if (!(data[b >> 3] & (1 << (b & 7)))) continue;
+        if (used == length || data[used] == 0) return 0;
+        lengths[b] = data[used++];
+    }
+    CodeWord codes[256];
+    return canonicalCodes(lengths, codes) ? used : 0;
+}
+
+// 共享编码表的码长及由其建立的编码器和解码器，建立后只读，各线程可以同时使用
+struct HfaSharedTable {
+    bool present = false;
+    uint8_t lengths[256] = {};
+    HuffmanBitEncoder encoder;
+    HuffmanTableDecoder decoder;
+
+    bool build(const uint8_t codeLengths[256]) {
+        CodeWord codes[256];
+        if (!canonicalCodes(codeLengths, codes)) return false;
+        std::memcpy(lengths, codeLengths, 256);
+        for (int b = 0; b < 256; b++) encoder.setCode(static_cast<unsigned char>(b), codes[b]);
+        present = decoder.build(codeListFromLengths(lengths));
+        return present;
+    }
+};
+
+// 编码一条记录（data 已加密）：比较用共享编码表和用私有编码表（含表本身）的字节数，
+// 取较小者写入 record 并返回所用的编码表。共享编码表缺少成员中出现的字节时只能用私有编码表
+inline uint8_t encodeArchiveRecord(const unsigned char* data, size_t n, const HfaSharedTable& shared,
+                                   int maxLength, std::vector<unsigned char>& record) {
+    uint64_t counts[256] = {};
+    countBytes(data, n, counts);
+    uint8_t lengths[256];
+    archiveCodeLengths(counts, maxLength, lengths);
+    uint64_t privateBytes = privateTableSize(lengths) + (codeLengthWpl(counts, lengths) + 7) / 8;
+    bool useShared = shared.present;
+    for (int b = 0; b < 256 && useShared; b++) {
+        if (counts[b] && !shared.lengths[b]) useShared = false;
+    }
+    useShared = useShared && (codeLengthWpl(counts, shared.lengths) + 7) / 8 <= privateBytes;
+
+    record.clear();
+    HuffmanBitEncoder privateEncoder;
+    const HuffmanBitEncoder* encoder = &shared.encoder;
+    if (!useShared) {
+        appendPrivateTable(record, lengths);
+        CodeWord codes[256];
+        canonicalCodes(lengths, codes);
+        for (int b = 0; b < 256; b++) privateEncoder.setCode(static_cast<unsigned char>(b), codes[b]);
+        encoder = &privateEncoder;
+    }
+    BitWriter writer(record, 4096);
+    encoder->encode(data, n, writer);
+    writer.finish();
+    return useShared ? HFA_TABLE_SHARED : HFA_TABLE_PRIVATE;
+}
+
+// 解码一条记录（不解密），out 的大小即原始长度。记录被截断或编码无效时返回 false
+inline bool decodeArchiveRecord(const unsigned char* record, size_t length, const HfaEntry& entry,
+                                const HfaSharedTable& shared, std::vector<unsigned char>& out) {
+    // 每个符号至少占1位，原始长度超过记录位数的目录项已损坏，不按它分配内存
+    if (entry.originalSize > static_cast<uint64_t>(length) * 8) return false;
+    out.resize(static_cast<size_t>(entry.originalSize));
+    if (out.empty()) return true;
+    HuffmanTableDecoder privateDecoder;
+    const HuffmanTableDecoder* decoder = &shared.decoder;
+    if (entry.table == HFA_TABLE_PRIVATE) {
+        uint8_t lengths[256];
+        size_t used = readPrivateTable(record, length, lengths);
+        if (used == 0 || !privateDecoder.build(codeListFromLengths(lengths))) return false;
+        record += used;
+        length -= used;
+        decoder = &privateDecoder;
+    } else if (!shared.present) {
+        return false;
+    }
+    BitReader reader(record, length);
+    return decoder->decodeSymbols(reader, out.data(), out.size()) == out.size();
+}
+
+#endif
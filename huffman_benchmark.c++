@@ -0,0 +1,1043 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "huffman_archive.h"
+#include "huffman_bits.h"
+#include "huffman_container.h"
+#include "huffman_model.h"
+#include "huffman_parallel.h"
+#include "huffman_stream.h"
+#include "huffman_symbols.h"
+#include "huffman_table_decoder.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+using namespace std;
+using namespace chrono;
+
+// 压缩/解压各阶段的基准测试：对固定语料依次测量哈希、词频统计、建树、编码、文件写入、
+// 头部处理，以及全部解码方式（逐位解码树、编码映射表、查找表、流式、分块并行、多字节符号），
+// 最后把语料切成小文件测量批量归档。
+// 每项先清空缓存冷测一次，再重复热测取中位数和最快值，报告 MB/s 和每字节周期数。
+// 所有阶段都按语料原始大小折算，各阶段的周期/字节可以直接相加比较占比。
+// 除文件写入阶段外只测内存中的计算，不含交互输入、加密和读文件
+//
+// 用法：huffman_benchmark [选项] [文件...]
+//   --reps N                   每项热测的重复次数（默认5）
+//   --synthetic 分布:大小      加入合成语料，如 zipf:64M、skewed:2G，可给出多次
+//   --generate 文件 分布:大小  只把合成数据写入文件后退出，内存占用固定，用于生成多GB输入
+//   --csv 文件、--json 文件    同时写出机器可读的结果
+//   --baseline 文件            与以前 --csv 的结果比较，热测中位速度下降超过
+//                              --tolerance 百分比（默认10）的项逐一列出，并以返回值2退出
+//   --slow-limit 大小          逐位解码树和映射表只测不超过该大小的语料（默认4M）
+//   --evict 大小               冷测前遍历的缓冲区大小（默认128M），应大于末级缓存
+//   --threads N                分块并行测试的线程数，0 表示全部CPU核心
+// 不给文件和合成语料时，使用仓库自带的语料和每种分布各16M的合成语料。
+// 合成分布：uniform 均匀随机字节；zipf 按 Zipf 分布取字节，接近文本；skewed 几何分布，
+// 编码很长，覆盖子表查找；cjk 按 Zipf 分布取常用汉字的 UTF-8 文本，覆盖多字节符号模式
+
+volatile uint64_t benchmarkSink;  // 写入计算结果，防止被测代码被优化掉
+
+// 时间戳计数器（x86 的 rdtsc）按固定频率计数，不随睿频变化，得到的是参考周期数。
+// 其他平台没有可移植的读法，只报告时间
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+const bool HAS_CYCLE_COUNTER = true;
+inline uint64_t readCycles() { return __rdtsc(); }
+#else
+const bool HAS_CYCLE_COUNTER = false;
+inline uint64_t readCycles() { return 0; }
+#endif
+
+struct Sample {
+    double seconds = 0;
+    uint64_t cycles = 0;
+};
+
+struct Measurement {
+    string corpus;
+    uint64_t corpusBytes = 0;
+    string stage;              // hash、histogram、tree、encode、write、header、decode
+    string variant;            // 同一阶段的不同实现或字符集
+    uint64_t outputBytes = 0;  // 编码阶段为容器头部 + 索引或符号表 + 位流的大小，其余为0
+    int reps = 0;
+    Sample cold;
+    Sample warmMedian;
+    Sample warmMin;
+    bool ok = true;
+};
+
+double megabytesPerSecond(uint64_t bytes, double seconds) {
+    return seconds > 0 ? bytes / seconds / 1e6 : 0;
+}
+
+double cyclesPerByte(uint64_t cycles, uint64_t bytes) {
+    return bytes ? static_cast<double>(cycles) / bytes : 0;
+}
+
+// 按终端显示宽度补齐到 width 列：UTF-8 中三字节及以上的字符（汉字、全角标点）占两列。
+// setw 按字节计宽，表头含汉字时会错位
+string padded(const string& text, size_t width, bool alignLeft) {
+    size_t columns = 0;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t n = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        columns += n >= 3 ? 2 : 1;
+        i += n;
+    }
+    string fill(columns < width ? width - columns : 0, ' ');
+    return alignLeft ? text + fill : fill + text;
+}
+
+string formatNumber(double value, int precision) {
+    ostringstream out;
+    out << fixed << setprecision(precision) << value;
+    return out.str();
+}
+
+// 解析 "64M"、"2G"、"512K" 或纯数字形式的字节数，失败返回 false
+bool parseSize(const string& text, uint64_t& size) {
+    if (text.empty() || !isdigit(static_cast<unsigned char>(text[0]))) return false;
+    size_t end = 0;
+    unsigned long long value = stoull(text, &end);
+    string suffix = text.substr(end);
+    int shift = 0;
+    if (suffix == "K" || suffix == "k") shift = 10;
+    else if (suffix == "M" || suffix == "m") shift = 20;
+    else if (suffix == "G" || suffix == "g") shift = 30;
+    else if (!suffix.empty()) return false;
+    size = static_cast<uint64_t>(value) << shift;
+    return true;
+}
+
+// ---------------- 合成语料 ----------------
+
+enum class Distribution { UNIFORM, ZIPF, SKEWED, CJK };
+
+struct SyntheticSpec {
+    Distribution distribution = Distribution::UNIFORM;
+    uint64_t size = 0;
+    string text;  // 命令行中的原始写法，用作语料名
+};
+
+bool parseSyntheticSpec(const string& text, SyntheticSpec& spec) {
+    size_t colon = text.find(':');
+    if (colon == string::npos) return false;
+    string name = text.substr(0, colon);
+    if (name == "uniform") spec.distribution = Distribution::UNIFORM;
+    else if (name == "zipf") spec.distribution = Distribution::ZIPF;
+    else if (name == "skewed") spec.distribution = Distribution::SKEWED;
+    else if (name == "cjk") spec.distribution = Distribution::CJK;
+    else return false;
+    spec.text = text;
+    return parseSize(text.substr(colon + 1), spec.size) && spec.size > 0;
+}
+
+// splitmix64 伪随机数：固定种子下各平台结果一致（标准库的分布类在不同实现中结果不同）
+class SplitMix64 {
+private:
+    uint64_t state;
+
+public:
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// 按权重抽取下标：累积权重换算到 [0, 2^32]，用随机数的高32位二分查找。
+// 权重占比小于 2^-32 的项抽不到
+class WeightedSampler {
+private:
+    vector<uint64_t> cumulative;
+
+public:
+    explicit WeightedSampler(const vector<double>& weights) {
+        double total = 0;
+        for (double w : weights) total += w;
+        double prefix = 0;
+        for (double w : weights) {
+            prefix += w;
+            cumulative.push_back(static_cast<uint64_t>(prefix / total * 4294967296.0));
+        }
+        cumulative.back() = uint64_t(1) << 32;
+    }
+
+    size_t sample(SplitMix64& rng) const {
+        uint64_t r = rng.next() >> 32;
+        return upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin();
+    }
+};
+
+// 合成数据源：fill 依次产生后续数据，同一分布每次运行的结果完全相同
+class SyntheticSource {
+private:
+    static const uint64_t SEED = 20240601;
+    static const int CJK_CHARACTERS = 3000;
+
+    Distribution distribution;
+    SplitMix64 rng;
+    unique_ptr<WeightedSampler> sampler;
+    vector<string> tokens;  // cjk：标点、换行和汉字的 UTF-8 编码
+    string carry;           // cjk：上次 fill 末尾没有放下的字符剩余部分
+
+    static vector<double> zipfWeights(size_t n) {
+        vector<double> weights(n);
+        for (size_t r = 0; r < n; r++) weights[r] = 1.0 / (r + 1);
+        return weights;
+    }
+
+public:
+    explicit SyntheticSource(Distribution d) : distribution(d), rng(SEED + static_cast<int>(d)) {
+        if (d == Distribution::ZIPF) {
+            sampler.reset(new WeightedSampler(zipfWeights(256)));
+        } else if (d == Distribution::SKEWED) {
+            vector<double> weights(256);
+            for (int r = 0; r < 256; r++) weights[r] = ldexp(1.0, -r);
+            sampler.reset(new WeightedSampler(weights));
+        } else if (d == Distribution::CJK) {
+            tokens = {"，", "。", "\n", "的", "了", "是"};
+            for (int i = 0; i < CJK_CHARACTERS; i++) {
+                unsigned char bytes[4];
+                int n = keyToBytes(SymbolAlphabet::UTF8, 0x4E00 + static_cast<uint32_t>(i) * 7, bytes);
+                tokens.emplace_back(reinterpret_cast<const char*>(bytes), n);
+            }
+            sampler.reset(new WeightedSampler(zipfWeights(tokens.size())));
+        }
+    }
+
+    void fill(unsigned char* dst, size_t n) {
+        switch (distribution) {
+        case Distribution::UNIFORM:
+            for (size_t i = 0; i < n; i += 8) {
+                uint64_t word = rng.next();
+                memcpy(dst + i, &word, min<size_t>(8, n - i));
+            }
+            break;
+        case Distribution::ZIPF:
+        case Distribution::SKEWED:
+            for (size_t i = 0; i < n; i++) dst[i] = static_cast<unsigned char>(sampler->sample(rng));
+            break;
+        case Distribution::CJK:
+            for (size_t i = 0; i < n;) {
+                if (carry.empty()) carry = tokens[sampler->sample(rng)];
+                size_t k = min(carry.size(), n - i);
+                memcpy(dst + i, carry.data(), k);
+                carry.erase(0, k);
+                i += k;
+            }
+            break;
+        }
+    }
+};
+
+// 按 1MB 的块生成合成数据交给 sink(data, n)，内存占用与总大小无关
+template <typename Sink>
+void generateSynthetic(const SyntheticSpec& spec, Sink sink) {
+    SyntheticSource source(spec.distribution);
+    vector<unsigned char> chunk(1 << 20);
+    for (uint64_t done = 0; done < spec.size;) {
+        size_t n = static_cast<size_t>(min<uint64_t>(chunk.size(), spec.size - done));
+        source.fill(chunk.data(), n);
+        sink(chunk.data(), n);
+        done += n;
+    }
+}
+
+// ---------------- 旧的逐位解码方式 ----------------
+
+// 与 decom_v1.c++ 的 decompress 相同的逐位解码树，只把文件读写换成内存
+struct TreeNode {
+    unsigned char byte = 0;
+    bool isLeaf = false;
+    TreeNode* left = nullptr;
+    TreeNode* right = nullptr;
+};
+
+class DecodeTree {
+private:
+    vector<unique_ptr<TreeNode>> nodes;
+
+    TreeNode* newNode() {
+        nodes.emplace_back(new TreeNode());
+        return nodes.back().get();
+    }
+
+public:
+    TreeNode* root = nullptr;
+
+    explicit DecodeTree(const vector<pair<unsigned char, CodeWord>>& codes) {
+        root = newNode();
+        for (const auto& pair : codes) {
+            TreeNode* current = root;
+            for (char bit : codeWordToString(pair.second)) {
+                TreeNode*& child = bit == '0' ? current->left : current->right;
+                if (!child) child = newNode();
+                current = child;
+            }
+            current->byte = pair.first;
+            current->isLeaf = true;
+        }
+    }
+
+    size_t decode(const vector<unsigned char>& in, unsigned char* out, size_t count) const {
+        const TreeNode* current = root;
+        size_t decoded = 0;
+        for (size_t i = 0; i < in.size() && decoded < count; i++) {
+            unsigned char curByte = in[i];
+            for (int bitPos = 7; bitPos >= 0 && decoded < count; bitPos--) {
+                current = ((curByte >> bitPos) & 1) ? current->right : current->left;
+                if (!current) return decoded;
+                if (current->isLeaf) {
+                    out[decoded++] = current->byte;
+                    current = root;
+                }
+            }
+        }
+        return decoded;
+    }
+};
+
+// 与 decom_v1.c++ 的 decompressWithMap 相同：逐位拼接编码串，每位查一次映射表
+size_t decodeWithMap(const map<string, unsigned char>& codeMap, const vector<unsigned char>& in,
+                     unsigned char* out, size_t count) {
+    string currentCode;
+    size_t decoded = 0;
+    for (size_t i = 0; i < in.size() && decoded < count; i++) {
+        unsigned char curByte = in[i];
+        for (int bitPos = 7; bitPos >= 0 && decoded < count; bitPos--) {
+            currentCode += ((curByte >> bitPos) & 1) ? '1' : '0';
+            auto it = codeMap.find(currentCode);
+            if (it != codeMap.end()) {
+                out[decoded++] = it->second;
+                currentCode.clear();
+            }
+        }
+    }
+    return decoded;
+}
+
+// 写入预分配内存的输出流，分块并行解码用它代替 ostringstream，避免反复扩容
+class MemoryStreamBuf : public streambuf {
+private:
+    unsigned char* base;
+    size_t capacity;
+    size_t used = 0;
+
+protected:
+    streamsize xsputn(const char* s, streamsize n) override {
+        size_t k = min(static_cast<size_t>(n), capacity - used);
+        memcpy(base + used, s, k);
+        used += k;
+        return static_cast<streamsize>(k);
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof()) || used == capacity) return traits_type::eof();
+        base[used++] = static_cast<unsigned char>(c);
+        return c;
+    }
+
+public:
+    MemoryStreamBuf(unsigned char* data, size_t size) : base(data), capacity(size) {}
+};
+
+// ---------------- 测量 ----------------
+
+struct Options {
+    int reps = 5;
+    uint64_t slowLimit = 4 << 20;
+    uint64_t evictBytes = 128 << 20;
+    unsigned threads = 0;
+    string csvPath;
+    string jsonPath;
+    string baselinePath;
+    double tolerance = 10;
+    vector<string> files;
+    vector<SyntheticSpec> synthetic;
+};
+
+struct Corpus {
+    string name;
+    vector<unsigned char> data;
+};
+
+class BenchmarkSuite {
+private:
+    static constexpr double MIN_SAMPLE_SECONDS = 0.01;
+
+    const Options& options;
+    vector<unsigned char> evictBuffer;
+    vector<Measurement> results;
+
+    // 读写一遍大于末级缓存的缓冲区，把语料、编码表和输出缓冲区挤出缓存
+    void evictCaches() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < evictBuffer.size(); i += 64) sum += ++evictBuffer[i];
+        benchmarkSink = sum;
+    }
+
+    // 连续运行 iterations 次，返回平均每次的时间和周期数
+    template <typename Fn>
+    static Sample run(Fn& fn, int iterations) {
+        auto start = steady_clock::now();
+        uint64_t startCycles = readCycles();
+        for (int i = 0; i < iterations; i++) fn();
+        uint64_t endCycles = readCycles();
+        Sample s;
+        s.seconds = duration<double>(steady_clock::now() - start).count() / iterations;
+        s.cycles = (endCycles - startCycles) / iterations;
+        return s;
+    }
+
+public:
+    ThreadPool pool;
+
+    explicit BenchmarkSuite(const Options& opts)
+        : options(opts), evictBuffer(static_cast<size_t>(opts.evictBytes)), pool(opts.threads) {}
+
+    // 测量一个阶段：清空缓存后冷测一次（同时起预热作用），再热测 reps 次。
+    // 单次很短的阶段每次热测连续运行多遍，凑够 MIN_SAMPLE_SECONDS 后取平均，减小计时误差。
+    // 调用方检查结果、补上 ok 和 outputBytes 后交给 record
+    template <typename Fn>
+    Measurement measure(const Corpus& corpus, const string& stage, const string& variant, Fn fn) {
+        Measurement m;
+        m.corpus = corpus.name;
+        m.corpusBytes = corpus.data.size();
+        m.stage = stage;
+        m.variant = variant;
+        m.reps = options.reps;
+        evictCaches();
+        m.cold = run(fn, 1);
+        Sample probe = run(fn, 1);
+        int iterations = static_cast<int>(min(1e6, MIN_SAMPLE_SECONDS / max(probe.seconds, 1e-9))) + 1;
+        vector<Sample> warm;
+        for (int i = 0; i < options.reps; i++) warm.push_back(run(fn, iterations));
+        sort(warm.begin(), warm.end(), [](const Sample& a, const Sample& b) { return a.seconds < b.seconds; });
+        m.warmMin = warm.front();
+        m.warmMedian = warm[warm.size() / 2];
+        return m;
+    }
+
+    static void printTableHeader() {
+        cout << padded("语料", 24, true) << ' ' << padded("阶段", 10, true) << padded("方式", 11, true)
+             << padded("冷MB/s", 11, false) << padded("热MB/s", 11, false) << padded("最快MB/s", 11, false)
+             << padded("冷周期/B", 10, false) << padded("热周期/B", 10, false)
+             << padded("输出字节", 11, false) << "  校验" << endl;
+    }
+
+    void record(const Measurement& m) {
+        auto cycles = [&](const Sample& s) {
+            return HAS_CYCLE_COUNTER ? formatNumber(cyclesPerByte(s.cycles, m.corpusBytes), 2) : string("-");
+        };
+        cout << padded(m.corpus, 24, true) << ' ' << padded(m.stage, 10, true) << padded(m.variant, 11, true)
+             << padded(formatNumber(megabytesPerSecond(m.corpusBytes, m.cold.seconds), 1), 11, false)
+             << padded(formatNumber(megabytesPerSecond(m.corpusBytes, m.warmMedian.seconds), 1), 11, false)
+             << padded(formatNumber(megabytesPerSecond(m.corpusBytes, m.warmMin.seconds), 1), 11, false)
+             << padded(cycles(m.cold), 10, false) << padded(cycles(m.warmMedian), 10, false)
+             << padded(m.outputBytes ? to_string(m.outputBytes) : string("-"), 11, false)
+             << "  " << (m.ok ? "通过" : "失败") << endl;
+        results.push_back(m);
+    }
+
+    const vector<Measurement>& measurements() const { return results; }
+};
+
+// 与 huffman_compress.c++ 的 buildUserInfoHeader 格式相同的用户信息头部
+string sampleUserInfoHeader() {
+    string header;
+    header += "发送方学号: U202312345\n";
+    header += "发送方姓名: sender\n";
+    header += "接收方学号: U202312345\n";
+    header += "接收方姓名: xt\n";
+    header += "------------------------\n";
+    return header;
+}
+
+// 多字节符号模式的统计、建表、编码和解码
+void benchmarkAlphabet(BenchmarkSuite& suite, const Corpus& corpus, SymbolAlphabet alphabet,
+                       const string& variant, vector<unsigned char>& decoded) {
+    const vector<unsigned char>& data = corpus.data;
+    unique_ptr<SymbolCounter> counter;
+    Measurement m = suite.measure(corpus, "histogram", variant, [&] {
+        counter.reset(new SymbolCounter(alphabet));
+        counter->add(data.data(), data.size());
+        counter->flush();
+    });
+    suite.record(m);
+
+    HfmSymbolTable table;
+    uint8_t byteLengths[256];
+    vector<uint64_t> counts;
+    m = suite.measure(corpus, "tree", variant, [&] {
+        buildSymbolModel(*counter, HFM_MAX_CODE_LENGTH, table, byteLengths, counts);
+    });
+    suite.record(m);
+
+    HuffmanSymbolEncoder encoder;
+    vector<unsigned char> encoded;
+    bool built = encoder.build(byteLengths, table);
+    m = suite.measure(corpus, "encode", variant, [&] {
+        encoded.clear();
+        BitWriter writer(encoded);
+        encoder.encode(data.data(), data.size(), writer);
+        encoder.flush(writer);
+        writer.finish();
+    });
+    m.ok = built;
+    m.outputBytes = HFM_HEADER_SIZE + table.byteSize() + encoded.size();
+    suite.record(m);
+
+    HuffmanTableDecoder decoder;
+    HfmHeader header;
+    memcpy(header.codeLengths, byteLengths, sizeof(byteLengths));
+    built = buildSymbolDecoder(decoder, header, table);
+    size_t got = 0;
+    m = suite.measure(corpus, "decode", variant, [&] {
+        BitReader reader(encoded.data(), encoded.size());
+        got = decoder.decodeBytes(reader, decoded.data(), data.size());
+    });
+    m.ok = built && got >= data.size() && equal(data.begin(), data.end(), decoded.begin());
+    suite.record(m);
+}
+
+// 批量归档：语料切成 1KB 的小文件，分别用各自的私有编码表和在样本上训练的共享编码表
+// 并行编码、解码。输出字节数含归档头部和目录（成员名按10个字节计），可与单个 .hfm 比较
+void benchmarkArchive(BenchmarkSuite& suite, const Corpus& corpus) {
+    const vector<unsigned char>& data = corpus.data;
+    const size_t memberSize = 1024;
+    const size_t members = (data.size() + memberSize - 1) / memberSize;
+    uint64_t sampleCounts[256] = {};
+    countBytes(data.data(), static_cast<size_t>(min<uint64_t>(data.size(), HFA_SAMPLE_BYTES)), sampleCounts);
+    uint8_t sharedLengths[256];
+    trainSharedLengths(sampleCounts, HFM_MAX_CODE_LENGTH, sharedLengths);
+
+    vector<vector<unsigned char>> records(members);
+    vector<vector<unsigned char>> outputs(members);
+    vector<HfaEntry> entries(members);
+    for (const string variant : {"hfa_private", "hfa_shared"}) {
+        HfaSharedTable shared;
+        bool built = variant == "hfa_private" || shared.build(sharedLengths);
+        Measurement m = suite.measure(corpus, "encode", variant, [&] {
+            suite.pool.parallelFor(members, [&](size_t i) {
+                size_t length = min(memberSize, data.size() - i * memberSize);
+                entries[i].originalSize = length;
+                entries[i].table = encodeArchiveRecord(data.data() + i * memberSize, length, shared,
+                                                       HFM_MAX_CODE_LENGTH, records[i]);
+            });
+        });
+        m.ok = built;
+        m.outputBytes = HFA_HEADER_SIZE + (members + 1) * (31 + 10);
+        for (const vector<unsigned char>& record : records) m.outputBytes += record.size();
+        suite.record(m);
+
+        vector<char> ok(members);
+        m = suite.measure(corpus, "decode", variant, [&] {
+            suite.pool.parallelFor(members, [&](size_t i) {
+                ok[i] = decodeArchiveRecord(records[i].data(), records[i].size(), entries[i], shared, outputs[i]);
+            });
+        });
+        m.ok = built;
+        for (size_t i = 0; i < members && m.ok; i++) {
+            m.ok = ok[i] && equal(outputs[i].begin(), outputs[i].end(), data.begin() + i * memberSize);
+        }
+        suite.record(m);
+    }
+}
+
+void benchmarkCorpus(BenchmarkSuite& suite, const Options& options, const Corpus& corpus) {
+    const vector<unsigned char>& data = corpus.data;
+    const size_t n = data.size();
+    vector<unsigned char> decoded(n + HuffmanTableDecoder::MAX_SYMBOL_BYTES - 1);
+    auto roundTrip = [&](size_t got) { return got == n && equal(data.begin(), data.end(), decoded.begin()); };
+
+    // 哈希
+    Measurement m = suite.measure(corpus, "hash", "fnv1a", [&] {
+        benchmarkSink = fnv1a64Update(FNV64_OFFSET_BASIS, data.data(), n);
+    });
+    suite.record(m);
+    m = suite.measure(corpus, "hash", "crc32c", [&] { benchmarkSink = crc32cUpdate(0, data.data(), n); });
+    suite.record(m);
+
+    // 词频统计和建树
+    uint64_t counts[256];
+    m = suite.measure(corpus, "histogram", "bytes", [&] {
+        memset(counts, 0, sizeof(counts));
+        countBytes(data.data(), n, counts);
+    });
+    suite.record(m);
+
+    uint8_t lengths[256];
+    CodeWord codes[256];
+    m = suite.measure(corpus, "tree", "bytes", [&] {
+        if (huffmanCodeLengths(counts, 256, lengths) > HFM_MAX_CODE_LENGTH) {
+            limitedCodeLengths(counts, HFM_MAX_CODE_LENGTH, lengths);
+        }
+        canonicalCodes(lengths, codes);
+    });
+    suite.record(m);
+
+    bool limitedOk = false;
+    m = suite.measure(corpus, "tree", "limit11", [&] {
+        uint8_t limitedLengths[256];
+        CodeWord limitedCodes[256];
+        limitedOk = limitedCodeLengths(counts, 11, limitedLengths) && canonicalCodes(limitedLengths, limitedCodes);
+    });
+    m.ok = limitedOk;
+    suite.record(m);
+
+    // 编码：整段、分块并行和推/拉式流接口
+    HuffmanBitEncoder encoder;
+    for (int b = 0; b < 256; b++) encoder.setCode(static_cast<unsigned char>(b), codes[b]);
+    vector<unsigned char> encoded;
+    m = suite.measure(corpus, "encode", "bytes", [&] {
+        encoded.clear();
+        BitWriter writer(encoded);
+        encoder.encode(data.data(), n, writer);
+        writer.finish();
+    });
+    m.outputBytes = HFM_HEADER_SIZE + encoded.size();
+    suite.record(m);
+
+    const size_t blockSize = 1 << 20;
+    const size_t blockCount = (n + blockSize - 1) / blockSize;
+    vector<vector<unsigned char>> blockOutputs(blockCount);
+    m = suite.measure(corpus, "encode", "blocks", [&] {
+        suite.pool.parallelFor(blockCount, [&](size_t b) {
+            blockOutputs[b].clear();
+            BitWriter writer(blockOutputs[b]);
+            encoder.encode(data.data() + b * blockSize, min(blockSize, n - b * blockSize), writer);
+            writer.finish();
+        });
+    });
+    HfmBlockIndex blockIndex;
+    blockIndex.blockSize = static_cast<uint32_t>(blockSize);
+    string blockPayload;
+    for (const vector<unsigned char>& block : blockOutputs) {
+        blockIndex.bitOffsets.push_back(blockPayload.size() * 8);
+        blockPayload.append(block.begin(), block.end());
+    }
+    blockIndex.bitOffsets.push_back(blockPayload.size() * 8);
+    m.outputBytes = HFM_HEADER_SIZE + blockIndex.byteSize() + blockPayload.size();
+    suite.record(m);
+
+    vector<unsigned char> streamed;
+    bool streamOk = false;
+    m = suite.measure(corpus, "encode", "stream", [&] {
+        HuffmanStreamEncoder stream(lengths);
+        unsigned char buffer[1 << 16];
+        streamed.clear();
+        auto drain = [&] {
+            size_t got;
+            while ((got = stream.read(buffer, sizeof(buffer))) > 0) {
+                streamed.insert(streamed.end(), buffer, buffer + got);
+            }
+        };
+        for (size_t pos = 0; pos < n;) {
+            size_t accepted = stream.feed(data.data() + pos, min(sizeof(buffer), n - pos));
+            pos += accepted;
+            drain();
+            if (accepted == 0 && !stream.ok()) break;
+        }
+        stream.finish();
+        drain();
+        streamOk = stream.ok();
+    });
+    m.ok = streamOk && streamed == encoded;
+    m.outputBytes = HFM_HEADER_SIZE + streamed.size();
+    suite.record(m);
+
+    // 文件写入：容器头部和位流按 1MB 分段写入临时文件
+    HfmHeader header;
+    header.originalSize = n;
+    header.userInfoLength = static_cast<uint32_t>(sampleUserInfoHeader().size());
+    memcpy(header.codeLengths, lengths, sizeof(lengths));
+    const string tempPath = "huffman_benchmark.tmp";
+    bool written = false;
+    m = suite.measure(corpus, "write", "file", [&] {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        writeHfmHeader(out, header);
+        for (size_t pos = 0; pos < encoded.size(); pos += 1 << 20) {
+            out.write(reinterpret_cast<const char*>(encoded.data() + pos),
+                      min<size_t>(1 << 20, encoded.size() - pos));
+        }
+        out.close();
+        written = static_cast<bool>(out);
+    });
+    m.ok = written;
+    remove(tempPath.c_str());
+    suite.record(m);
+
+    // 头部处理：压缩端生成用户信息头部并写出容器头部，解压端读回头部并建立查找表
+    m = suite.measure(corpus, "header", "write", [&] {
+        ostringstream out;
+        string userInfo = sampleUserInfoHeader();
+        writeHfmHeader(out, header);
+        benchmarkSink = out.str().size() + userInfo.size();
+    });
+    suite.record(m);
+
+    ostringstream headerOut;
+    writeHfmHeader(headerOut, header);
+    const string headerBytes = headerOut.str();
+    HuffmanTableDecoder decoder;
+    bool headerOk = false;
+    m = suite.measure(corpus, "header", "read", [&] {
+        istringstream in(headerBytes);
+        HfmHeader parsed;
+        headerOk = readHfmHeader(in, parsed) && decoder.build(codeListFromLengths(parsed.codeLengths));
+    });
+    m.ok = headerOk;
+    suite.record(m);
+
+    // 解码：旧的逐位方式很慢，只测不超过 --slow-limit 的语料，其余方式全部都测
+    vector<pair<unsigned char, CodeWord>> codeList = codeListFromLengths(lengths);
+    size_t got = 0;
+    if (n <= options.slowLimit) {
+        DecodeTree tree(codeList);
+        m = suite.measure(corpus, "decode", "tree_walk", [&] { got = tree.decode(encoded, decoded.data(), n); });
+        m.ok = roundTrip(got);
+        suite.record(m);
+
+        map<string, unsigned char> codeMap;
+        for (const auto& pair : codeList) codeMap[codeWordToString(pair.second)] = pair.first;
+        m = suite.measure(corpus, "decode", "string_map", [&] {
+            got = decodeWithMap(codeMap, encoded, decoded.data(), n);
+        });
+        m.ok = roundTrip(got);
+        suite.record(m);
+    } else {
+        cout << padded(corpus.name, 24, true) << ' ' << "跳过逐位解码树和映射表（语料超过 --slow-limit）" << endl;
+    }
+
+    m = suite.measure(corpus, "decode", "table", [&] {
+        BitReader reader(encoded.data(), encoded.size());
+        got = decoder.decodeSymbols(reader, decoded.data(), n);
+    });
+    m.ok = roundTrip(got);
+    suite.record(m);
+
+    m = suite.measure(corpus, "decode", "stream", [&] {
+        HuffmanStreamDecoder stream(lengths, n);
+        size_t inPos = 0;
+        got = 0;
+        while (!stream.done()) {
+            size_t produced = stream.read(decoded.data() + got, n - got);
+            got += produced;
+            if (produced) continue;
+            size_t accepted = stream.feed(encoded.data() + inPos, min<size_t>(1 << 16, encoded.size() - inPos));
+            inPos += accepted;
+            if (accepted == 0) break;
+        }
+    });
+    m.ok = roundTrip(got);
+    suite.record(m);
+
+    istringstream blockInput(blockPayload);
+    m = suite.measure(corpus, "decode", "blocks", [&] {
+        MemoryStreamBuf buffer(decoded.data(), n);
+        ostream out(&buffer);
+        got = static_cast<size_t>(decodeBlocksParallel(blockInput, 0, out, decoder, blockIndex, n, suite.pool,
+                                                       [](unsigned char*, size_t, uint64_t) { return true; }));
+    });
+    m.ok = roundTrip(got);
+    suite.record(m);
+
+    benchmarkAlphabet(suite, corpus, SymbolAlphabet::UTF8, "utf8", decoded);
+    benchmarkAlphabet(suite, corpus, SymbolAlphabet::GBK, "gbk", decoded);
+    benchmarkArchive(suite, corpus);
+}
+
+// ---------------- 机器可读输出 ----------------
+
+const char* CSV_COLUMNS =
+    "corpus,corpus_bytes,stage,variant,output_bytes,reps,"
+    "cold_seconds,warm_median_seconds,warm_min_seconds,cold_mbps,warm_median_mbps,warm_min_mbps,"
+    "cold_cycles_per_byte,warm_median_cycles_per_byte,ok";
+
+string csvField(const string& text) {
+    if (text.find_first_of(",\"\n") == string::npos) return text;
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+vector<string> splitCsvLine(const string& line) {
+    vector<string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+// 每项一行；没有周期计数器时周期列留空
+bool writeCsv(const string& path, const vector<Measurement>& results) {
+    ofstream out(path);
+    if (!out) return false;
+    out << CSV_COLUMNS << "\n" << setprecision(9);
+    for (const Measurement& m : results) {
+        out << csvField(m.corpus) << ',' << m.corpusBytes << ',' << m.stage << ',' << m.variant << ','
+            << m.outputBytes << ',' << m.reps << ','
+            << m.cold.seconds << ',' << m.warmMedian.seconds << ',' << m.warmMin.seconds << ','
+            << megabytesPerSecond(m.corpusBytes, m.cold.seconds) << ','
+            << megabytesPerSecond(m.corpusBytes, m.warmMedian.seconds) << ','
+            << megabytesPerSecond(m.corpusBytes, m.warmMin.seconds) << ',';
+        if (HAS_CYCLE_COUNTER) {
+            out << cyclesPerByte(m.cold.cycles, m.corpusBytes) << ','
+                << cyclesPerByte(m.warmMedian.cycles, m.corpusBytes);
+        } else {
+            out << ',';
+        }
+        out << ',' << (m.ok ? 1 : 0) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+string jsonString(const string& text) {
+    string escaped = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            escaped += buf;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+bool writeJson(const string& path, const Options& options, unsigned threads, const vector<Measurement>& results) {
+    ofstream out(path);
+    if (!out) return false;
+    out << setprecision(9);
+    out << "{\n  \"reps\": " << options.reps << ",\n  \"threads\": " << threads
+        << ",\n  \"cycle_counter\": " << (HAS_CYCLE_COUNTER ? "\"tsc\"" : "null")
+#ifdef __VERSION__
+        << ",\n  \"compiler\": " << jsonString(__VERSION__)
+#endif
+        << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Measurement& m = results[i];
+        out << (i ? "," : "") << "\n    {\"corpus\": " << jsonString(m.corpus)
+            << ", \"corpus_bytes\": " << m.corpusBytes
+            << ", \"stage\": " << jsonString(m.stage) << ", \"variant\": " << jsonString(m.variant)
+            << ", \"output_bytes\": " << m.outputBytes << ", \"reps\": " << m.reps
+            << ", \"cold_seconds\": " << m.cold.seconds
+            << ", \"warm_median_seconds\": " << m.warmMedian.seconds
+            << ", \"warm_min_seconds\": " << m.warmMin.seconds
+            << ", \"warm_median_mbps\": " << megabytesPerSecond(m.corpusBytes, m.warmMedian.seconds);
+        if (HAS_CYCLE_COUNTER) {
+            out << ", \"cold_cycles_per_byte\": " << cyclesPerByte(m.cold.cycles, m.corpusBytes)
+                << ", \"warm_median_cycles_per_byte\": " << cyclesPerByte(m.warmMedian.cycles, m.corpusBytes);
+        }
+        out << ", \"ok\": " << (m.ok ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// 与以前的 CSV 结果按（语料, 阶段, 方式）对比热测中位速度，
+// 返回变慢超过容差的项数，读取失败返回 -1
+int compareWithBaseline(const string& path, double tolerance, const vector<Measurement>& results) {
+    ifstream in(path);
+    string line;
+    if (!in || !getline(in, line)) return -1;
+    vector<string> columns = splitCsvLine(line);
+    auto column = [&](const string& name) {
+        return static_cast<size_t>(find(columns.begin(), columns.end(), name) - columns.begin());
+    };
+    size_t corpusCol = column("corpus");
+    size_t stageCol = column("stage");
+    size_t variantCol = column("variant");
+    size_t speedCol = column("warm_median_mbps");
+    if (max({corpusCol, stageCol, variantCol, speedCol}) >= columns.size()) return -1;
+
+    map<string, double> baseline;
+    while (getline(in, line)) {
+        vector<string> fields = splitCsvLine(line);
+        if (fields.size() != columns.size()) continue;
+        baseline[fields[corpusCol] + "\n" + fields[stageCol] + "\n" + fields[variantCol]] = atof(fields[speedCol].c_str());
+    }
+
+    int regressions = 0;
+    cout << "\n与基准结果比较（" << path << "，容差 " << tolerance << "%）：" << endl;
+    for (const Measurement& m : results) {
+        auto it = baseline.find(m.corpus + "\n" + m.stage + "\n" + m.variant);
+        if (it == baseline.end() || it->second <= 0) continue;
+        double now = megabytesPerSecond(m.corpusBytes, m.warmMedian.seconds);
+        double change = (now / it->second - 1) * 100;
+        if (change < -tolerance) {
+            cout << "  变慢：" << m.corpus << " " << m.stage << "/" << m.variant << " "
+                 << formatNumber(it->second, 1) << " -> " << formatNumber(now, 1) << " MB/s（"
+                 << formatNumber(change, 1) << "%）" << endl;
+            regressions++;
+        }
+    }
+    if (regressions == 0) cout << "  没有超过容差的变慢项" << endl;
+    return regressions;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options, string& generatePath, SyntheticSpec& generateSpec) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--reps" && hasValue) {
+            options.reps = max(1, atoi(argv[++i]));
+        } else if (arg == "--synthetic" && hasValue) {
+            SyntheticSpec spec;
+            if (!parseSyntheticSpec(argv[++i], spec)) return false;
+            options.synthetic.push_back(spec);
+        } else if (arg == "--generate" && i + 2 < argc) {
+            generatePath = argv[++i];
+            if (!parseSyntheticSpec(argv[++i], generateSpec)) return false;
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerance = atof(argv[++i]);
+        } else if (arg == "--slow-limit" && hasValue) {
+            if (!parseSize(argv[++i], options.slowLimit)) return false;
+        } else if (arg == "--evict" && hasValue) {
+            if (!parseSize(argv[++i], options.evictBytes)) return false;
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(atoi(argv[++i]));
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    string generatePath;
+    SyntheticSpec generateSpec;
+    if (!parseOptions(argc, argv, options, generatePath, generateSpec)) {
+        cerr << "用法：huffman_benchmark [--reps N] [--synthetic 分布:大小] [--generate 文件 分布:大小]\n"
+                "                         [--csv 文件] [--json 文件] [--baseline 文件] [--tolerance 百分比]\n"
+                "                         [--slow-limit 大小] [--evict 大小] [--threads N] [文件...]\n"
+                "分布为 uniform、zipf、skewed、cjk，大小可带 K/M/G 后缀" << endl;
+        return 1;
+    }
+
+    if (!generatePath.empty()) {
+        ofstream out(generatePath, ios::binary);
+        generateSynthetic(generateSpec, [&](const unsigned char* data, size_t n) {
+            out.write(reinterpret_cast<const char*>(data), n);
+        });
+        out.close();
+        if (!out) {
+            cerr << "无法写入文件：" << generatePath << endl;
+            return 1;
+        }
+        cout << "已生成 " << generatePath << "（" << generateSpec.text << "，" << generateSpec.size << " 字节）" << endl;
+        return 0;
+    }
+
+    if (options.files.empty() && options.synthetic.empty()) {
+        options.files = {"The_Wretched.txt", "middle.txt", "yuanxi.txt", "test_chn.txt"};
+        for (const char* text : {"uniform:16M", "zipf:16M", "skewed:16M", "cjk:16M"}) {
+            SyntheticSpec spec;
+            parseSyntheticSpec(text, spec);
+            options.synthetic.push_back(spec);
+        }
+    }
+
+    BenchmarkSuite suite(options);
+    cout << "每项冷测1次、热测" << options.reps << "次（取中位数和最快值），分块并行使用 "
+         << suite.pool.size() << " 个线程，周期"
+         << (HAS_CYCLE_COUNTER ? "为时间戳计数器的参考周期" : "不可用") << endl;
+    BenchmarkSuite::printTableHeader();
+
+    bool allOk = true;
+    auto run = [&](const Corpus& corpus) {
+        if (corpus.data.empty()) {
+            cerr << "语料为空，跳过：" << corpus.name << endl;
+            return;
+        }
+        benchmarkCorpus(suite, options, corpus);
+    };
+    for (const string& file : options.files) {
+        ifstream in(file, ios::binary);
+        if (!in) {
+            cerr << "无法打开文件：" << file << endl;
+            allOk = false;
+            continue;
+        }
+        Corpus corpus{file, vector<unsigned char>((istreambuf_iterator<char>(in)), istreambuf_iterator<char>())};
+        run(corpus);
+    }
+    for (const SyntheticSpec& spec : options.synthetic) {
+        Corpus corpus{"synthetic:" + spec.text, {}};
+        corpus.data.reserve(static_cast<size_t>(spec.size));
+        generateSynthetic(spec, [&](const unsigned char* data, size_t n) {
+            corpus.data.insert(corpus.data.end(), data, data + n);
+        });
+        run(corpus);
+    }
+
+    const vector<Measurement>& results = suite.measurements();
+    for (const Measurement& m : results) allOk = allOk && m.ok;
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        cerr << "无法写入 CSV 文件：" << options.csvPath << endl;
+        allOk = false;
+    }
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, suite.pool.size(), results)) {
+        cerr << "无法写入 JSON 文件：" << options.jsonPath << endl;
+        allOk = false;
+    }
+    if (!options.baselinePath.empty()) {
+        int regressions = compareWithBaseline(options.baselinePath, options.tolerance, results);
+        if (regressions < 0) {
+            cerr << "无法读取基准结果：" << options.baselinePath << endl;
+            return 1;
+        }
+        if (regressions > 0) return 2;
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+#ifndef HUFFMAN_BITS_H
+#define HUFFMAN_BITS_H
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+const uint64_t FNV64_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const uint64_t FNV64_PRIME = 0x100000001b3ULL;
+
+// 增量计算FNV-1a哈希，初值为 FNV64_OFFSET_BASIS
+inline uint64_t fnv1a64Update(uint64_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+// CRC32C（Castagnoli 多项式）。x86-64 上 CPU 支持 SSE4.2 时用 crc32 指令每次处理8个字节，
+// 否则用 slicing-by-8 查表，两者结果相同
+const uint32_t CRC32C_POLY = 0x82F63B78u;  // 反射形式
+
+struct Crc32cTables {
+    uint32_t t[8][256];
+    Crc32cTables() {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+            t[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; b++) {
+            for (int s = 1; s < 8; s++) t[s][b] = (t[s - 1][b] >> 8) ^ t[0][t[s - 1][b] & 0xFF];
+        }
+    }
+};
+
+inline uint32_t crc32cSoftware(uint32_t crc, const unsigned char* p, size_t length) {
+    static const Crc32cTables tables;
+    const uint32_t (*t)[256] = tables.t;
+    while (length >= 8) {
+        // 按小端取值，与字节序无关
+        uint32_t lo = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                      static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+        uint32_t hi = static_cast<uint32_t>(p[4]) | static_cast<uint32_t>(p[5]) << 8 |
+                      static_cast<uint32_t>(p[6]) << 16 | static_cast<uint32_t>(p[7]) << 24;
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HUFFMAN_HAS_CRC32C_INSTRUCTION 1
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cHardware(uint32_t crc, const unsigned char* p, size_t length) {
+    uint64_t c = crc;
+    while (length >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = __builtin_ia32_crc32di(c, word);
+        p += 8;
+        length -= 8;
+    }
+    crc = static_cast<uint32_t>(c);
+    while (length--) crc = __builtin_ia32_crc32qi(crc, *p++);
+    return crc;
+}
+
+inline bool crc32cHardwareAvailable() {
+    static const bool available = __builtin_cpu_supports("sse4.2");
+    return available;
+}
+#endif
+
+// 增量计算CRC32C，初值为0：crc32cUpdate(crc32cUpdate(0, a), b) 等于 a、b 拼接后的校验值
+inline uint32_t crc32cUpdate(uint32_t crc, const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#ifdef HUFFMAN_HAS_CRC32C_INSTRUCTION
+    if (crc32cHardwareAvailable()) return ~crc32cHardware(crc, p, length);
+#endif
+    return ~crc32cSoftware(crc, p, length);
+}
+
+// 校验算法编号，写入容器头部
+const uint8_t HFM_CHECKSUM_FNV1A = 0;   // 64 位 FNV-1a，兼容旧版本
+const uint8_t HFM_CHECKSUM_CRC32C = 1;
+
+// 按指定算法增量计算的校验值
+class Checksum {
+private:
+    uint8_t type;
+    uint64_t state;
+
+public:
+    explicit Checksum(uint8_t algorithm = HFM_CHECKSUM_CRC32C)
+        : type(algorithm), state(algorithm == HFM_CHECKSUM_CRC32C ? 0 : FNV64_OFFSET_BASIS) {}
+
+    void update(const void* data, size_t length) {
+        if (type == HFM_CHECKSUM_CRC32C) {
+            state = crc32cUpdate(static_cast<uint32_t>(state), data, length);
+        } else {
+            state = fnv1a64Update(state, data, length);
+        }
+    }
+
+    uint64_t value() const { return state; }
+    uint8_t algorithm() const { return type; }
+};
+
+// 单个符号的哈夫曼编码：bits 右对齐保存，高位先输出
+struct CodeWord {
+    uint64_t bits = 0;
+    uint8_t length = 0;
+};
+
+// 把 "0101" 形式的编码串转换为 CodeWord，超过64位返回 false
+inline bool codeStringToWord(const std::string& code, CodeWord& word) {
+    if (code.length() > 64) return false;
+    word.bits = 0;
+    word.length = static_cast<uint8_t>(code.length());
+    for (char bit : code) {
+        word.bits = (word.bits << 1) | (bit == '1' ? 1u : 0u);
+    }
+    return true;
+}
+
+// CodeWord 转回 "0101" 形式的编码串
+inline std::string codeWordToString(const CodeWord& word) {
+    std::string code;
+    for (int i = word.length - 1; i >= 0; i--) {
+        code += ((word.bits >> i) & 1) ? '1' : '0';
+    }
+    return code;
+}
+
+// 从字节流或内存按高位优先读取比特，内部使用64位缓冲区，一次补充多个字节
+class BitReader {
+private:
+    std::istream* in;  // 为空时直接读取构造时给定的内存区间
+    std::vector<unsigned char> buffer;
+    const unsigned char* cur = nullptr;
+    const unsigned char* end = nullptr;
+
+    // 从输入流读取下一块数据
+    bool fetch() {
+        if (!in) return false;
+        in->read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        std::streamsize got = in->gcount();
+        cur = buffer.data();
+        end = cur + (got > 0 ? got : 0);
+        return got > 0;
+    }
+
+public:
+    uint64_t bitBuf = 0;  // 有效位左对齐，其余位保持为0
+    int bitCount = 0;     // bitBuf 中的有效位数
+
+    explicit BitReader(std::istream& input, size_t blockSize = 1 << 20)
+        : in(&input), buffer(blockSize) {}
+
+    BitReader(const unsigned char* data, size_t size)
+        : in(nullptr), cur(data), end(data + size) {}
+
+    // 补充到至少56位有效位（输入耗尽时可能更少）
+    void refill() {
+        if (bitCount > 56) return;
+        if (end - cur >= 8) {
+            uint64_t word = 0;
+            for (int i = 0; i < 8; i++) {
+                word = (word << 8) | cur[i];
+            }
+            bitBuf |= word >> bitCount;
+            int bytes = (63 - bitCount) >> 3;
+            cur += bytes;
+            bitCount += bytes * 8;
+            return;
+        }
+        while (bitCount <= 56) {
+            if (cur == end && !fetch()) return;
+            bitBuf |= static_cast<uint64_t>(*cur++) << (56 - bitCount);
+            bitCount += 8;
+        }
+    }
+
+    uint32_t peek(int n) const {
+        return static_cast<uint32_t>(bitBuf >> (64 - n));
+    }
+
+    void consume(int n) {
+        bitBuf <<= n;
+        bitCount -= n;
+    }
+
+    // 跳过不足一个字节的起始位
+    void skipBits(int n) {
+        refill();
+        consume(n);
+    }
+
+    // 内存模式下尚未消耗的位数
+    uint64_t remainingBits() const {
+        return static_cast<uint64_t>(end - cur) * 8 + bitCount;
+    }
+};
+
+// 按高位优先写出比特：编码先拼入64位累加器，满一个字即整字写入大缓冲区，
+// 缓冲区满时才写入输出流。同时统计输出字节数、CRC32C校验值和最后16个字节
+class BitWriter {
+private:
+    std::ostream* out;  // 为空时只统计不输出
+    std::vector<unsigned char>* sink = nullptr;  // 非空时追加到内存
+    std::vector<unsigned char> buffer;
+    size_t used = 0;
+    uint64_t acc = 0;   // 待写出的位左对齐存放
+    int accBits = 0;
+
+    uint64_t totalBytes = 0;
+    Checksum digest;    // 输出字节的校验值
+    unsigned char tail[16] = {};
+
+    void putWord(uint64_t word) {
+        if (buffer.size() - used < 8) flushBuffer();
+        for (int i = 0; i < 8; i++) {
+            buffer[used++] = static_cast<unsigned char>(word >> (56 - 8 * i));
+        }
+    }
+
+    void flushBuffer() {
+        if (used == 0) return;
+        digest.update(buffer.data(), used);
+        // 保留最后16个字节
+        if (used >= 16) {
+            std::memcpy(tail, buffer.data() + used - 16, 16);
+        } else {
+            std::memmove(tail, tail + used, 16 - used);
+            std::memcpy(tail + 16 - used, buffer.data(), used);
+        }
+        if (out) out->write(reinterpret_cast<const char*>(buffer.data()), used);
+        if (sink) sink->insert(sink->end(), buffer.begin(), buffer.begin() + used);
+        totalBytes += used;
+        used = 0;
+    }
+
+public:
+    explicit BitWriter(std::ostream* output, size_t bufferSize = 1 << 20)
+        : out(output), buffer(bufferSize < 8 ? 8 : bufferSize) {}
+
+    // 输出追加到内存，用于分块并行编码
+    explicit BitWriter(std::vector<unsigned char>& memory, size_t bufferSize = 1 << 16)
+        : out(nullptr), sink(&memory), buffer(bufferSize < 8 ? 8 : bufferSize) {}
+
+    // 写入 length 位（bits 右对齐，高位无多余的1）
+    void put(uint64_t bits, int length) {
+        int free = 64 - accBits;
+        if (length < free) {
+            acc |= bits << (free - length);
+            accBits += length;
+            return;
+        }
+        int rest = length - free;
+        acc |= bits >> rest;
+        putWord(acc);
+        accBits = rest;
+        acc = rest ? bits << (64 - rest) : 0;
+    }
+
+    // 写出剩余位，最后一个字节低位补0
+    void finish() {
+        int bytes = (accBits + 7) / 8;
+        for (int i = 0; i < bytes; i++) {
+            if (used == buffer.size()) flushBuffer();
+            buffer[used++] = static_cast<unsigned char>(acc >> (56 - 8 * i));
+        }
+        acc = 0;
+        accBits = 0;
+        flushBuffer();
+    }
+
+    // 把缓冲区中的完整字节交给输出，累加器中不足一个字的位保留
+    void flush() { flushBuffer(); }
+
+    uint64_t bytesWritten() const { return totalBytes; }
+    // 已写入的总位数（含尚在缓冲区和累加器中的位）
+    uint64_t bitPosition() const { return (totalBytes + used) * 8 + accBits; }
+    // 输出校验值的算法，默认 CRC32C，须在写入数据之前设置
+    void setChecksum(uint8_t algorithm) { digest = Checksum(algorithm); }
+    uint64_t outputChecksum() const { return digest.value(); }
+
+    // 返回最后 min(16, 总字节数) 个字节
+    std::vector<unsigned char> lastBytes() const {
+        size_t n = totalBytes < 16 ? static_cast<size_t>(totalBytes) : 16;
+        return std::vector<unsigned char>(tail + 16 - n, tail + 16);
+    }
+};
+
+// 字节到编码的定长查找表编码器
+class HuffmanBitEncoder {
+private:
+    CodeWord codes[256];
+
+public:
+    void setCode(unsigned char byte, const CodeWord& word) { codes[byte] = word; }
+    const CodeWord& code(unsigned char byte) const { return codes[byte]; }
+
+    void encode(const unsigned char* data, size_t length, BitWriter& writer) const {
+        for (size_t i = 0; i < length; i++) {
+            const CodeWord& c = codes[data[i]];
+            writer.put(c.bits, c.length);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef HUFFMAN_CHECKSUM_H
+#define HUFFMAN_CHECKSUM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "huffman_bits.h"
+#include "huffman_container.h"
+
+// 压缩时计算、解压时比对的校验值。整个文件的校验值按头部记录的算法（CRC32C 或兼容旧版本的
+// FNV-1a）计算，块校验表总是 CRC32C。两者都针对加密前的原始数据（含用户信息头部），
+// 解压时在解密之后、写出之前边解码边比对，不需要重新读取输出文件
+
+const uint32_t HFM_DEFAULT_CHECKSUM_UNIT = 1 << 20;  // 没有块索引和同步点时的校验单元大小
+
+inline const char* checksumName(uint8_t type) {
+    return type == HFM_CHECKSUM_CRC32C ? "CRC32C" : "FNV-1a";
+}
+
+// 按算法的位数显示为十六进制，如 CRC32C 为 0x1A2B3C4D
+inline std::string formatChecksum(uint8_t type, uint64_t value) {
+    char text[24];
+    std::snprintf(text, sizeof(text), "0x%0*llX", type == HFM_CHECKSUM_CRC32C ? 8 : 16,
+                  static_cast<unsigned long long>(value));
+    return text;
+}
+
+// 单独校验第 i 个单元，分块并行解码时各线程对自己的块调用
+inline bool checkBlockChecksum(const HfmChecksumIndex& index, size_t i, const unsigned char* data, size_t length) {
+    return i < index.checksums.size() && crc32cUpdate(0, data, length) == index.checksums[i];
+}
+
+// 压缩时按顺序送入数据，同时得到整个文件的校验值和每 unit 字节一项的块校验表。
+// unit 为0时不生成块校验表
+class ChecksumBuilder {
+private:
+    Checksum whole;
+    HfmChecksumIndex blocks;
+    uint32_t current = 0;
+    uint64_t position = 0;
+
+public:
+    ChecksumBuilder(uint8_t type, uint32_t unit) : whole(type) {
+        blocks.unit = unit;
+    }
+
+    void update(const unsigned char* data, size_t length) {
+        whole.update(data, length);
+        if (blocks.unit == 0) return;
+        while (length > 0) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(length, blocks.unit - position % blocks.unit));
+            current = crc32cUpdate(current, data, take);
+            data += take;
+            length -= take;
+            position += take;
+            if (position % blocks.unit == 0) {
+                blocks.checksums.push_back(current);
+                current = 0;
+            }
+        }
+    }
+
+    uint64_t value() const { return whole.value(); }
+
+    // 数据结束：补上最后一个不完整的单元，返回块校验表
+    const HfmChecksumIndex& finish() {
+        if (blocks.unit && blocks.checksums.size() < (position + blocks.unit - 1) / blocks.unit) {
+            blocks.checksums.push_back(current);
+            current = 0;
+        }
+        return blocks;
+    }
+};
+
+// 解压时按顺序送入解出的数据：每凑满一个校验单元就与块校验表比对，在第一个不一致的单元处
+// 返回 false，调用方随即停止解码；finish 在数据结束时比对最后一个单元和整个文件的校验值。
+// blocks 为空时只计算整个文件的校验值
+class ChecksumVerifier {
+private:
+    const HfmChecksumIndex* blocks;
+    uint64_t expected;
+    uint64_t totalSize;
+    Checksum whole;
+    uint32_t current = 0;
+    uint64_t position = 0;
+    uint64_t good = 0;      // 已通过校验的数据长度
+    size_t badBlock = SIZE_MAX;
+    int result = -1;        // finish 的结果，-1 表示尚未调用
+
+    bool closeBlock() {
+        size_t i = static_cast<size_t>((position - 1) / blocks->unit);
+        if (i >= blocks->checksums.size() || current != blocks->checksums[i]) {
+            badBlock = i;
+            return false;
+        }
+        current = 0;
+        good = position;
+        return true;
+    }
+
+public:
+    ChecksumVerifier(const HfmHeader& header, const HfmChecksumIndex* index)
+        : blocks(index && index->unit ? index : nullptr), expected(header.dataHash),
+          totalSize(header.originalSize), whole(header.checksum) {}
+
+    bool update(const unsigned char* data, size_t length) {
+        if (failed()) return false;
+        whole.update(data, length);
+        if (!blocks) {
+            position += length;
+            return true;
+        }
+        while (length > 0) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(length, blocks->unit - position % blocks->unit));
+            current = crc32cUpdate(current, data, take);
+            data += take;
+            length -= take;
+            position += take;
+            if (position % blocks->unit == 0 && !closeBlock()) return false;
+        }
+        return true;
+    }
+
+    // 数据结束时调用：长度不足、最后一个单元或整个文件的校验值不一致时返回 false。可重复调用
+    bool finish() {
+        if (result < 0) {
+            bool ok = !failed() && position == totalSize &&
+                      (!blocks || position % blocks->unit == 0 || closeBlock()) && whole.value() == expected;
+            if (ok) good = position;
+            result = ok;
+        }
+        return result != 0;
+    }
+
+    bool failed() const { return badBlock != SIZE_MAX; }
+    bool checksPerUnit() const { return blocks != nullptr; }
+    // 已确认无误的数据长度：逐单元校验时为通过校验的完整单元，否则只有 finish 成功后才是全部数据
+    uint64_t verifiedBytes() const { return good; }
+    // 第一个校验失败的单元序号及其在原始数据中的起点
+    size_t failedBlock() const { return badBlock; }
+    uint64_t failedOffset() const { return blocks ? static_cast<uint64_t>(badBlock) * blocks->unit : 0; }
+    uint64_t value() const { return whole.value(); }
+    uint64_t expectedValue() const { return expected; }
+    uint8_t algorithm() const { return whole.algorithm(); }
+};
+
+// 解压输出的缓冲：逐单元校验时，写入的数据先暂存，所在单元通过校验后才写到 out，
+// 暂存量不超过一个校验单元加一次写入的长度，损坏单元的数据不会落盘。
+// 写入前应已把同一段数据送入 verifier；没有块校验表时无法提前确认，数据直接写出
+class VerifiedOutputBuffer : public std::streambuf {
+private:
+    std::ostream& out;
+    const ChecksumVerifier& verifier;
+    std::string held;
+    uint64_t released = 0;  // 已写到 out 的长度
+
+    void forward(uint64_t limit) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(held.size(), limit - std::min(limit, released)));
+        if (n == 0) return;
+        out.write(held.data(), static_cast<std::streamsize>(n));
+        held.erase(0, n);
+        released += n;
+    }
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize n) override {
+        if (!verifier.checksPerUnit()) {
+            out.write(data, n);
+            released += static_cast<uint64_t>(n);
+            return out ? n : 0;
+        }
+        held.append(data, static_cast<size_t>(n));
+        forward(verifier.verifiedBytes());
+        return out ? n : 0;
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        char ch = traits_type::to_char_type(c);
+        return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+    }
+
+public:
+    VerifiedOutputBuffer(std::ostream& target, const ChecksumVerifier& checker) : out(target), verifier(checker) {}
+
+    // verifier.finish 之后调用：写出已确认的剩余数据，未通过校验的部分丢弃
+    void release() {
+        forward(verifier.verifiedBytes());
+        held.clear();
+    }
+
+    uint64_t bytesReleased() const { return released; }
+};
+
+#endif
@@ -5,19 +5,33 @@
 #include <map>
 #include <iomanip>
 #include <string>
-#define FNV1A_64_INIT 0xcbf29ce484222325ULL
-#define FNV1A_64_PRIME 0x100000001b3
+#include <limits>
+#include "huffman_bits.h"
+#include "huffman_checksum.h"
+#include "huffman_container.h"
+#include "huffman_parallel.h"
+#include "huffman_stream.h"
+#include "huffman_model.h"
+#include "huffman_symbols.h"
+#include "huffman_archive.h"
+#include <array>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <cstdlib>
 #include <cstdint>
 using namespace std;
 
 // 定义哈夫曼树节点结构
 struct HuffmanNode {
     unsigned char byte;     // 字节值
-    int frequency;         // 词频
+    uint64_t frequency;    // 词频
     HuffmanNode* left;     // 左子节点
     HuffmanNode* right;    // 右子节点
     
-    HuffmanNode(unsigned char b, int freq) : 
+    HuffmanNode(unsigned char b, uint64_t freq) : 
         byte(b), frequency(freq), left(nullptr), right(nullptr) {}
 };
 // 添加用户信息结构体：
@@ -35,11 +49,39 @@ enum class EncryptionType {
     OFFSET,
     XOR_KEY
 };
+// 压缩输出格式
+enum class OutputFormat {
+    CONTAINER,          // 自描述容器：头部内含规范码长，不生成编码表文件
+    LEGACY_CODE_TABLE   // 旧格式：位流 + code_bin.txt / code.txt
+};
 
 class HuffmanCompression {
 private:
-    vector<HuffmanNode*> heap;
+    vector<HuffmanNode> nodePool;            // 哈夫曼树节点，每次建树时整体重用
     map<unsigned char, string> huffmanCodes; // 存储每个字节的哈夫曼编码
+    uint64_t leafCounts[256] = {};           // generateCodes 收集的各叶子词频
+    int maxCodeLength = 0;                   // 码长上限，0 表示不限制
+    HuffmanBitEncoder bitEncoder;            // 256项 (编码位, 长度) 整数表，用于压缩
+    // 最近一次编码的输出统计，供 encodeAndShowLast16Bytes 使用
+    string lastEncodedFile;
+    uint64_t lastEncodedSize = 0;
+    uint64_t lastEncodedChecksum = 0;
+    vector<unsigned char> lastEncodedTail;
+    // 输出格式及容器头部
+    OutputFormat outputFormat = OutputFormat::CONTAINER;
+    HfmHeader containerHeader;
+    // 同步点索引：每 syncInterval 字节记录一次位偏移，0 表示不写入
+    uint32_t syncInterval = 0;
+    HfmSyncIndex syncIndex;     // 编码过程中填写，interval 为0时不记录
+    size_t syncKeyLength = 0;   // XOR 密钥长度，用于计算同步点的密钥下标
+    // 校验算法（仅容器格式，旧格式总是 FNV-1a）；CRC32C 时同时写入块校验表
+    uint8_t checksumType = HFM_CHECKSUM_CRC32C;
+    HfmChecksumIndex checksumIndex;
+    // 多字节符号模式（仅容器格式）：symbolAlphabet 为用户选择，symbolTable.alphabet
+    // 为当前文件实际使用的字符集，符号模式没有更小时退回单字节
+    SymbolAlphabet symbolAlphabet = SymbolAlphabet::BYTES;
+    HfmSymbolTable symbolTable;
+    HuffmanSymbolEncoder symbolEncoder;
      // 添加密钥常量
     static const uint8_t OFFSET_VALUE = 0x55;
     // 堆的比较函数：词频小的优先，词频相同时按字节值排序
@@ -51,61 +93,27 @@ private:
         return a->byte < b->byte;
     }
     
-    // 向下调整堆
-    void heapify(int index, int size) {
-        int smallest = index;
-        int left = 2 * index + 1;
-        int right = 2 * index + 2;
-        
-        // 找到最小值的索引
-        if (left < size && compareNodes(heap[left], heap[smallest])) {
-            smallest = left;
-        }
-        if (right < size && compareNodes(heap[right], heap[smallest])) {
-            smallest = right;
-        }
-        
-        // 如果最小值不是当前节点，交换并继续向下调整
-        if (smallest != index) {
-            swap(heap[index], heap[smallest]);
-            heapify(smallest, size);
-        }
-    }
-    
-    // 建立最小堆
-    void buildMinHeap() {
-        for (int i = heap.size() / 2 - 1; i >= 0; i--) {
-            heapify(i, heap.size());
-        }
-    }
-    
-    // 获取并删除堆顶元素
-    HuffmanNode* extractMin() {
-        if (heap.empty()) return nullptr;
-        
-        HuffmanNode* minNode = heap[0];
-        heap[0] = heap.back();
-        heap.pop_back();
-        
-        if (!heap.empty()) {
-            heapify(0, heap.size());
-        }
-        
-        return minNode;
+    // 生成哈夫曼编码：沿途的编码串在同一个缓冲区中追加、回退，不为每个节点拼接新串
+    void generateCodes(HuffmanNode* root) {
+        memset(leafCounts, 0, sizeof(leafCounts));
+        string path;
+        generateCodes(root, path);
     }
+    void generateCodes(HuffmanNode* node, string& path) {
+        if (!node) return;
 
-    // 生成哈夫曼编码
-    void generateCodes(HuffmanNode* root, string code = "") {
-        if (!root) return;
-        
         // 叶子节点
-        if (!root->left && !root->right) {
-            huffmanCodes[root->byte] = code;
+        if (!node->left && !node->right) {
+            huffmanCodes[node->byte] = path;
+            leafCounts[node->byte] = node->frequency;
             return;
         }
-        
-        generateCodes(root->left, code + "0");
-        generateCodes(root->right, code + "1");
+
+        path.push_back('0');
+        generateCodes(node->left, path);
+        path.back() = '1';
+        generateCodes(node->right, path);
+        path.pop_back();
     }
 
     // 将二进制字符串转换为字节
@@ -122,66 +130,54 @@ private:
         return bytes;
     }
 
-    // 添加FNV-1a哈希计算函数
-    uint64_t fnv1a_64(const void *data, size_t length) {
-        uint64_t hash = FNV1A_64_INIT;
-        const uint8_t *byte_data = (const uint8_t *)data;
-        for (size_t i = 0; i < length; i++) {
-            hash ^= byte_data[i];
-            hash *= FNV1A_64_PRIME;
-        }
-        return hash;
-    }
-    // 计算文件的hash值
+    // 计算文件的hash值（当前使用的校验算法）
     uint64_t calculateFileHash(const string& filename) {
+        ChecksumBuilder checksums(activeChecksum(), 0);
+        checksumFile(filename, checksums);
+        return checksums.value();
+    }
+
+    // 分块读取文件并送入 checksums，内存占用与文件大小无关
+    bool checksumFile(const string& filename, ChecksumBuilder& checksums) {
         ifstream file(filename, ios::binary);
         if (!file) {
             cerr << "无法打开文件进行哈希计算：" << filename << endl;
-            return 0;
+            return false;
         }
+        vector<uint8_t> buffer(1 << 20);
+        while (file) {
+            file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+            checksums.update(buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+        return true;
+    }
 
-        // 获取文件大小
-        file.seekg(0, ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, ios::beg);
-
-        // 读取文件内容
-        vector<uint8_t> buffer(fileSize);
-        file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
-        file.close();
-
-        // 计算哈希值
-        return fnv1a_64(buffer.data(), fileSize);
+    // 实际使用的校验算法：旧格式没有地方记录算法，保持 FNV-1a
+    uint8_t activeChecksum() const {
+        return outputFormat == OutputFormat::CONTAINER ? checksumType : HFM_CHECKSUM_FNV1A;
     }
 
-    // 将二进制位串写入文件
-    void writeBitsToFile(const string& bits, ofstream& outFile) {
-        for (size_t i = 0; i < bits.length(); i += 8) {
-            string byte = bits.substr(i, std::min<size_t>(8ul, bits.length() - i));
-            while (byte.length() < 8) {
-                byte += '0';  // 在末尾补0
-            }
-            unsigned char value = static_cast<unsigned char>(stoi(byte, nullptr, 2));
-            outFile.write(reinterpret_cast<const char*>(&value), 1);
-        }
+    // 块校验表的单元大小：分块模式与块一致，有同步点时与同步间隔一致，便于按块或按范围解压时
+    // 逐单元校验；FNV-1a（兼容旧版本）时不写块校验表，返回0
+    uint32_t checksumUnit(size_t blockSize = 0) const {
+        if (activeChecksum() != HFM_CHECKSUM_CRC32C) return 0;
+        if (blockSize) return static_cast<uint32_t>(blockSize);
+        return syncInterval ? syncInterval : HFM_DEFAULT_CHECKSUM_UNIT;
     }
 
-    void siftUp(int index) {
-        while (index > 0) {
-            int parent = (index - 1) / 2;
-            if (compareNodes(heap[index], heap[parent])) {
-                swap(heap[index], heap[parent]);
-                index = parent;
-            } else {
-                break;
-            }
-        }
+    // 显示一个校验值，如 “原始文件哈希值（CRC32C）: 0x1A2B3C4D”
+    void printChecksum(const string& label, uint64_t value) {
+        cout << label << "（" << checksumName(activeChecksum()) << "）: "
+             << formatChecksum(activeChecksum(), value) << endl;
     }
 
-    // 修改插入节点的方法
-    void insertNode(HuffmanNode* node) {
-        heap.push_back(node);
-        siftUp(heap.size() - 1);
+    // 显示压缩后位流的校验值，算法与头部一致；FNV-1a 时保持旧版本的输出
+    void printOutputChecksum(uint64_t value) {
+        if (activeChecksum() == HFM_CHECKSUM_CRC32C) {
+            cout << "压缩后CRC32C校验值: " << formatChecksum(HFM_CHECKSUM_CRC32C, value) << endl;
+        } else {
+            cout << "压缩后FNV-1a哈希值: 0x" << hex << uppercase << value << dec << endl;
+        }
     }
 
     vector<unsigned char> userInfoToBytes(const UserInfo& info) {
@@ -239,16 +235,461 @@ private:
         return encryptedFile;
     }
 
+    bool symbolMode() const {
+        return symbolTable.alphabet != SymbolAlphabet::BYTES;
+    }
+
+    // 把一段数据在边界处切开：边界为 interval 的整数倍（interval 非0时）和 headerEnd。
+    // 每到一个边界调用 boundary(位置)，两个边界之间的数据交给 run(data, n)
+    template <typename Run, typename Boundary>
+    static void splitAtBoundaries(const unsigned char* data, size_t length, uint64_t& offset,
+                                  uint64_t interval, uint64_t headerEnd, Run run, Boundary boundary) {
+        while (length > 0) {
+            if ((interval && offset % interval == 0) || offset == headerEnd) boundary(offset);
+            uint64_t next = interval ? offset - offset % interval + interval : UINT64_MAX;
+            if (headerEnd > offset) next = min(next, headerEnd);
+            size_t take = static_cast<size_t>(min<uint64_t>(length, next - offset));
+            run(data, take);
+            data += take;
+            length -= take;
+            offset += take;
+        }
+    }
+
+    // 编码一段数据，offset 为其在原始数据中的位置；记录同步点时在每个间隔边界登记位偏移。
+    // 多字节符号不跨越同步点和用户信息头部末尾，解码时在这些位置总是符号的起点
+    void encodeChunk(const unsigned char* data, size_t length, uint64_t& offset, BitWriter& writer) {
+        if (syncIndex.interval == 0 && !symbolMode()) {
+            bitEncoder.encode(data, length, writer);
+            offset += length;
+            return;
+        }
+        splitAtBoundaries(data, length, offset, syncIndex.interval,
+            symbolMode() ? containerHeader.userInfoLength : 0,
+            [&](const unsigned char* run, size_t n) {
+                if (symbolMode()) {
+                    symbolEncoder.encode(run, n, writer);
+                } else {
+                    bitEncoder.encode(run, n, writer);
+                }
+            },
+            [&](uint64_t position) {
+                if (symbolMode()) symbolEncoder.flush(writer);
+                if (syncIndex.interval && position % syncIndex.interval == 0 &&
+                    position / syncIndex.interval < syncIndex.points.size()) {
+                    HfmSyncPoint& point = syncIndex.points[position / syncIndex.interval];
+                    point.bitOffset = writer.bitPosition();
+                    point.keyIndex = syncKeyLength ? static_cast<uint32_t>(position % syncKeyLength) : 0;
+                }
+            });
+    }
+
+    // 写出暂存的不完整字符和最后不足一个字节的位
+    void finishEncoding(BitWriter& writer) {
+        if (symbolMode()) symbolEncoder.flush(writer);
+        writer.finish();
+    }
+
+    // 多字节符号模式下统计一段待压缩数据，切分边界与 encodeChunk 一致
+    void countSymbols(SymbolCounter& counter, const unsigned char* data, size_t length, uint64_t& offset,
+                      uint64_t headerLength) {
+        splitAtBoundaries(data, length, offset, syncInterval, headerLength,
+            [&](const unsigned char* run, size_t n) { counter.add(run, n); },
+            [&](uint64_t) { counter.flush(); });
+    }
+
+    // 统计待压缩文件（用户信息头部 + 原文件，可能已加密）中的多字节符号
+    bool countSymbolsFromFile(const string& filename, uint64_t headerLength, SymbolCounter& counter) {
+        ifstream file(filename, ios::binary);
+        if (!file) return false;
+        vector<unsigned char> block(1 << 20);
+        uint64_t offset = 0;
+        while (file) {
+            file.read(reinterpret_cast<char*>(block.data()), block.size());
+            countSymbols(counter, block.data(), static_cast<size_t>(file.gcount()), offset, headerLength);
+        }
+        counter.flush();
+        return true;
+    }
+
+    // 由统计结果选出多字节符号、求出码长并建立编码器，显示与单字节模式的比较。
+    // 加上符号表后没有比单字节模式更小时，本文件仍按单字节编码
+    void buildSymbolCodes(const SymbolCounter& counter, EncryptionType encType) {
+        cout << "\n多字节符号模式（" << alphabetName(counter.alphabet) << "）：" << endl;
+        if (encType != EncryptionType::NONE) {
+            cout << "注意：符号按加密后的数据统计，加密后的数据通常不再是有效文本" << endl;
+        }
+        uint8_t byteLengths[256];
+        vector<uint64_t> counts;
+        HfmSymbolTable table;
+        buildSymbolModel(counter, maxCodeLength > 0 ? maxCodeLength : HFM_MAX_CODE_LENGTH,
+                         table, byteLengths, counts);
+        vector<uint8_t> lengths(byteLengths, byteLengths + 256);
+        lengths.insert(lengths.end(), table.lengths.begin(), table.lengths.end());
+        uint64_t symbolWpl = codeLengthWpl(counts.data(), lengths.data(), counts.size());
+        uint64_t symbolCount = 0;
+        for (uint64_t c : counts) symbolCount += c;
+
+        // 单字节模式的码长即当前编码表
+        uint8_t plainLengths[256] = {};
+        for (const auto& pair : huffmanCodes) {
+            plainLengths[pair.first] = static_cast<uint8_t>(max<size_t>(pair.second.length(), 1));
+        }
+        uint64_t byteWpl = codeLengthWpl(leafCounts, plainLengths);
+        uint64_t symbolBytes = (symbolWpl + 7) / 8 + table.byteSize();
+        uint64_t byteBytes = (byteWpl + 7) / 8;
+
+        cout << "入选符号表的多字节字符: " << table.keys.size() << " 种，符号表 "
+             << table.byteSize() << " 字节" << endl;
+        cout << "符号数: " << symbolCount << "（平均每个符号 " << fixed << setprecision(2)
+             << (symbolCount ? static_cast<double>(counter.totalBytes) / symbolCount : 0.0) << " 字节）" << endl;
+        cout << "单字节模式WPL值：" << byteWpl << "，位流 " << byteBytes << " 字节" << endl;
+        cout << "符号模式WPL值：" << symbolWpl << "，位流加符号表 " << symbolBytes << " 字节" << endl;
+        if (table.keys.empty() || symbolBytes >= byteBytes) {
+            cout << "符号模式没有更小，本文件使用单字节模式" << endl;
+            return;
+        }
+        cout << "预计压缩率：" << fixed << setprecision(2)
+             << calculateCompressionRatio(counter.totalBytes, symbolBytes * 8) << "%" << endl;
+        memcpy(containerHeader.codeLengths, byteLengths, sizeof(byteLengths));
+        symbolTable = table;
+        symbolEncoder.build(byteLengths, symbolTable);
+    }
+
+    // 按块编码输入流，outFile 为空时只统计输出字节数、哈希值和最后16个字节
+    void encodeStream(ifstream& inFile, ofstream* outFile) {
+        BitWriter writer(outFile);
+        writer.setChecksum(activeChecksum());
+        vector<unsigned char> block(1 << 20);
+        uint64_t offset = 0;
+        while (inFile) {
+            inFile.read(reinterpret_cast<char*>(block.data()), block.size());
+            size_t got = static_cast<size_t>(inFile.gcount());
+            if (got == 0) break;
+            encodeChunk(block.data(), got, offset, writer);
+        }
+        finishEncoding(writer);
+        lastEncodedSize = writer.bytesWritten();
+        lastEncodedChecksum = writer.outputChecksum();
+        lastEncodedTail = writer.lastBytes();
+    }
+
+    // 用户信息头部文本，与原文件内容拼接后一起压缩
+    string buildUserInfoHeader(const UserInfo& userInfo) {
+        string header;
+        header += "发送方学号: " + userInfo.senderID + "\n";
+        header += "发送方姓名: " + userInfo.senderName + "\n";
+        header += "接收方学号: " + userInfo.receiverID + "\n";
+        header += "接收方姓名: " + userInfo.receiverName + "\n";
+        header += "------------------------\n";
+        return header;
+    }
+
+    // 在扩展名前插入后缀，例如 a.txt -> a_added.txt
+    string insertSuffix(const string& filename, const string& suffix) {
+        size_t lastDot = filename.find_last_of('.');
+        if (lastDot != string::npos) {
+            return filename.substr(0, lastDot) + suffix + filename.substr(lastDot);
+        }
+        return filename + suffix;
+    }
+
+    // 对一块数据原地加密，keyIndex 跨块累计
+    void encryptBlock(unsigned char* data, size_t length, EncryptionType type,
+                      const string& key, size_t& keyIndex) {
+        switch (type) {
+            case EncryptionType::OFFSET:
+                for (size_t i = 0; i < length; i++) data[i] += OFFSET_VALUE;
+                break;
+            case EncryptionType::XOR_KEY:
+                for (size_t i = 0; i < length; i++) data[i] ^= key[keyIndex++ % key.length()];
+                break;
+            default:
+                break;
+        }
+    }
+
+    // 依次把用户信息头部和源文件内容按大块交给 visit(data, length, isHeader) 处理
+    template <typename Visitor>
+    bool scanWithHeader(const string& filename, const string& header, vector<unsigned char>& block,
+                        Visitor visit) {
+        ifstream inFile(filename, ios::binary);
+        if (!inFile) {
+            cerr << "无法打开源文件：" << filename << endl;
+            return false;
+        }
+        vector<unsigned char> headerBytes(header.begin(), header.end());
+        visit(headerBytes.data(), headerBytes.size(), true);
+        while (inFile) {
+            inFile.read(reinterpret_cast<char*>(block.data()), block.size());
+            size_t got = static_cast<size_t>(inFile.gcount());
+            if (got == 0) break;
+            visit(block.data(), got, false);
+        }
+        return true;
+    }
+
+    // 流水线和分块模式共用：显示哈希值和词频统计，建立（加密后）编码表，
+    // 返回与 compressFile 一致的逻辑文件名
+    string reportAndBuildCodes(const string& filename, uint64_t fileSize, uint64_t origin_hash,
+                               uint64_t processed_hash, const uint64_t plainCounts[256],
+                               const uint64_t encCounts[256], EncryptionType encType) {
+        printChecksum("原始文件哈希值", origin_hash);
+        printChecksum("\n添加用户信息后的文件哈希值", processed_hash);
+
+        vector<pair<unsigned char, uint64_t>> frequencies = countsToFrequencies(plainCounts);
+        displayFileStats(fileSize, frequencies);
+
+        HuffmanNode* root = buildHuffmanTree(frequencies);
+        uint64_t ori_wpl = calculateWPL(root);
+        displayCompressionStats(fileSize, ori_wpl);
+        generateCodeTable(fileSize, root);
+        displayCodeTable();
+
+        // 输出文件名与 compressFile 保持一致
+        string processedFile = insertSuffix(filename, "_added");
+        if (encType != EncryptionType::NONE) {
+            cout << "\n开始加密处理..." << endl;
+            cout << "加密方式: " << (encType == EncryptionType::OFFSET ? "偏移" : "XOR") << endl;
+            cout << "加密前WPL值：" << ori_wpl << endl;
+
+            frequencies = countsToFrequencies(encCounts);
+            root = buildHuffmanTree(frequencies);
+            uint64_t ecp_wpl = calculateWPL(root);
+
+            cout << "加密后WPL值：" << ecp_wpl << endl;
+            if (ecp_wpl != ori_wpl) {
+                cout << "警告：加密前后WPL值不一致！" << endl;
+            }
+
+            generateCodeTable(fileSize, root);
+            displayCodeTable();
+            processedFile = insertSuffix(processedFile, "_ecp");
+        }
+
+        return processedFile;
+    }
+
+    // 由逻辑文件名得到 .hfm 文件名
+    string hfmNameFor(const string& processedFile) {
+        string outputFilename = processedFile;
+        size_t lastDot = outputFilename.find_last_of('.');
+        if (lastDot != string::npos) {
+            outputFilename = outputFilename.substr(0, lastDot);
+        }
+        return outputFilename + ".hfm";
+    }
+
+    // 从“用户信息头部 + 源文件”组成的数据流中顺序读取最多 n 个字节，返回实际读取数
+    size_t readWithHeader(ifstream& inFile, const string& header, uint64_t& position,
+                          unsigned char* dst, size_t n) {
+        size_t filled = 0;
+        if (position < header.size()) {
+            filled = static_cast<size_t>(min<uint64_t>(n, header.size() - position));
+            memcpy(dst, header.data() + position, filled);
+        }
+        if (filled < n) {
+            inFile.read(reinterpret_cast<char*>(dst + filled), n - filled);
+            filled += static_cast<size_t>(inFile.gcount());
+        }
+        position += filled;
+        return filled;
+    }
+
+    // 256项计数转换为按字节值排序的词频列表
+    vector<pair<unsigned char, uint64_t>> countsToFrequencies(const uint64_t counts[256]) {
+        vector<pair<unsigned char, uint64_t>> frequencies;
+        for (int b = 0; b < 256; b++) {
+            if (counts[b]) frequencies.emplace_back(static_cast<unsigned char>(b), counts[b]);
+        }
+        return frequencies;
+    }
+
+    // 保留树的码长、改用规范哈夫曼编码，并记录到容器头部
+    void assignCanonicalCodes(uint64_t fileSize) {
+        HfmHeader& header = containerHeader;
+        memset(header.codeLengths, 0, sizeof(header.codeLengths));
+        for (const auto& pair : huffmanCodes) {
+            // 只有一种字节时树的编码长度为0，规范编码至少用1位
+            header.codeLengths[pair.first] = static_cast<uint8_t>(max<size_t>(pair.second.length(), 1));
+        }
+        header.originalSize = fileSize;
+
+        CodeWord codes[256];
+        canonicalCodes(header.codeLengths, codes);
+        for (auto& pair : huffmanCodes) {
+            pair.second = codeWordToString(codes[pair.first]);
+            bitEncoder.setCode(pair.first, codes[pair.first]);
+        }
+    }
+
+    // 记录容器头部中与编码表无关的字段，校验值和块校验表取自第一遍读取时的 checksums
+    void prepareContainerHeader(EncryptionType encType, size_t userInfoLength, ChecksumBuilder& checksums,
+                                const string& key) {
+        containerHeader.encryption = static_cast<uint8_t>(encType);
+        containerHeader.userInfoLength = static_cast<uint32_t>(userInfoLength);
+        containerHeader.checksum = activeChecksum();
+        containerHeader.dataHash = checksums.value();
+        checksumIndex = checksums.finish();
+        containerHeader.flags = syncInterval ? HFM_FLAG_SYNC_POINTS : 0;
+        if (checksumIndex.unit) containerHeader.flags |= HFM_FLAG_BLOCK_CHECKSUMS;
+        if (symbolMode()) containerHeader.flags |= HFM_FLAG_SYMBOLS;
+        syncKeyLength = encType == EncryptionType::XOR_KEY ? key.length() : 0;
+    }
+
+    // 写入容器头部；需要同步点时写入占位的同步点索引并开始记录，再写入块校验表，
+    // 多字节符号模式最后写入符号表
+    void writeContainerPrefix(ofstream& outFile) {
+        writeHfmHeader(outFile, containerHeader);
+        if (containerHeader.flags & HFM_FLAG_SYNC_POINTS) {
+            syncIndex.interval = syncInterval;
+            syncIndex.points.assign((containerHeader.originalSize + syncInterval - 1) / syncInterval,
+                                    HfmSyncPoint());
+            writeSyncIndex(outFile, syncIndex);
+        }
+        if (containerHeader.flags & HFM_FLAG_BLOCK_CHECKSUMS) {
+            writeChecksumIndex(outFile, checksumIndex);
+        }
+        if (containerHeader.flags & HFM_FLAG_SYMBOLS) {
+            writeSymbolTable(outFile, symbolTable);
+        }
+    }
+
+    // 编码结束后回填同步点索引
+    void finishContainer(ofstream& outFile) {
+        if (syncIndex.interval != 0) {
+            outFile.seekp(static_cast<streamoff>(HFM_HEADER_SIZE));
+            writeSyncIndex(outFile, syncIndex);
+            outFile.seekp(0, ios::end);
+            syncIndex.interval = 0;
+        }
+    }
+
+    // 批量归档的输入：目录时取其下（含子目录）全部普通文件，名称为相对该目录的路径；
+    // 否则为列表文件，每行一个文件路径，名称取给出的相对路径，绝对路径或含 ".." 时只取文件名
+    bool collectArchiveInputs(const string& inputPath, vector<string>& files, vector<string>& names) {
+        error_code ec;
+        vector<pair<string, string>> inputs;  // (名称, 路径)
+        if (filesystem::is_directory(inputPath, ec)) {
+            filesystem::path root(inputPath);
+            for (filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+                if (!it->is_regular_file(ec)) continue;
+                inputs.emplace_back(it->path().lexically_relative(root).generic_string(), it->path().string());
+            }
+            sort(inputs.begin(), inputs.end());
+        } else {
+            ifstream list(inputPath);
+            if (!list) {
+                cerr << "无法打开目录或文件列表：" << inputPath << endl;
+                return false;
+            }
+            string line;
+            while (getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+                string name = filesystem::path(line).generic_string();
+                if (!isSafeMemberName(name)) name = filesystem::path(line).filename().generic_string();
+                inputs.emplace_back(name, line);
+            }
+        }
+        if (ec) {
+            cerr << "读取目录失败：" << ec.message() << endl;
+            return false;
+        }
+        if (inputs.empty()) {
+            cerr << "没有要归档的文件！" << endl;
+            return false;
+        }
+        set<string> seen;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (!isSafeMemberName(inputs[i].first) || inputs[i].first.size() > 0xFFFF) {
+                cerr << "无法作为成员名称：" << inputs[i].second << endl;
+                return false;
+            }
+            if (!seen.insert(inputs[i].first).second) {
+                cerr << "成员名称重复：" << inputs[i].first << endl;
+                return false;
+            }
+            names.push_back(inputs[i].first);
+            files.push_back(inputs[i].second);
+        }
+        return true;
+    }
+
+    // 归档文件名：目录 docs/ 为 docs.hfa，列表文件 list.txt 为 list.hfa
+    string archiveNameFor(const string& inputPath) {
+        filesystem::path path = filesystem::absolute(inputPath).lexically_normal();
+        if (!path.has_filename()) path = path.parent_path();
+        return path.replace_extension(".hfa").string();
+    }
+
+    // 读入一个待归档的文件并加密（每个文件的密钥下标从0开始），crc 为加密前的 CRC32C
+    bool loadArchiveMember(const string& path, EncryptionType encType, const string& key,
+                           vector<unsigned char>& data, uint32_t& crc) {
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file) return false;
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<streamsize>(data.size()));
+        if (file.gcount() != static_cast<streamsize>(data.size())) return false;
+        crc = crc32cUpdate(0, data.data(), data.size());
+        size_t keyIndex = 0;
+        encryptBlock(data.data(), data.size(), encType, key, keyIndex);
+        return true;
+    }
+
+    // 在样本上训练共享编码表：按总大小计算间隔，每隔若干个文件取一个，样本约 HFA_SAMPLE_BYTES 字节，
+    // 覆盖整个输入列表。样本按加密后的数据统计，与实际编码的数据一致
+    bool trainSharedTable(const vector<string>& files, ThreadPool& pool, EncryptionType encType,
+                          const string& key, int maxLength, HfaSharedTable& shared) {
+        uint64_t totalSize = 0;
+        for (const string& file : files) totalSize += getFileSize(file);
+        size_t stride = static_cast<size_t>(max<uint64_t>(1, (totalSize + HFA_SAMPLE_BYTES - 1) / HFA_SAMPLE_BYTES));
+        vector<size_t> sample;
+        for (size_t i = 0; i < files.size(); i += stride) sample.push_back(i);
+
+        uint64_t counts[256] = {};
+        uint64_t sampleBytes = 0;
+        mutex countsMutex;
+        pool.parallelFor(sample.size(), [&](size_t k) {
+            vector<unsigned char> data;
+            uint32_t crc;
+            if (!loadArchiveMember(files[sample[k]], encType, key, data, crc)) return;
+            uint64_t local[256] = {};
+            countBytes(data.data(), data.size(), local);
+            lock_guard<mutex> lock(countsMutex);
+            for (int b = 0; b < 256; b++) counts[b] += local[b];
+            sampleBytes += data.size();
+        });
+
+        uint8_t lengths[256];
+        trainSharedLengths(counts, maxLength, lengths);
+        if (!shared.build(lengths)) {
+            cerr << "训练共享编码表失败！" << endl;
+            return false;
+        }
+        int longest = *max_element(begin(lengths), end(lengths));
+        cout << "共享编码表：在 " << sample.size() << " 个样本文件（" << sampleBytes << " 字节）上训练，最长编码 "
+             << longest << " 位" << endl;
+        return true;
+    }
+
     // 显示文件统计信息
-    void displayFileStats(const string& filename, const vector<pair<unsigned char, int>>& frequencies) {
-        cout << "\n处理后文件大小: " << getFileSize(filename) << " 字节" << endl;
+    void displayFileStats(const string& filename, const vector<pair<unsigned char, uint64_t>>& frequencies) {
+        displayFileStats(getFileSize(filename), frequencies);
+    }
+    void displayFileStats(uint64_t fileSize, const vector<pair<unsigned char, uint64_t>>& frequencies) {
+        cout << "\n处理后文件大小: " << fileSize << " 字节" << endl;
         cout << "不同字符数量: " << frequencies.size() << endl << endl;
         printFrequencyStats(frequencies);
     }
     // 显示压缩统计信息
-    void displayCompressionStats(const string& filename, int wpl) {
+    void displayCompressionStats(const string& filename, uint64_t wpl) {
+        displayCompressionStats(getFileSize(filename), wpl);
+    }
+    void displayCompressionStats(uint64_t fileSize, uint64_t wpl) {
         cout << "\n哈夫曼树的WPL值：" << wpl << endl;
-        double compressionRatio = calculateCompressionRatio(filename, wpl);
+        double compressionRatio = calculateCompressionRatio(fileSize, wpl);
         cout << "预计压缩率：" << fixed << setprecision(2) << compressionRatio << "%" << endl;
     }
 public:
@@ -272,11 +713,7 @@ public:
         }
 
         // 写入用户信息头部
-        tempFile << "发送方学号: " << userInfo.senderID << "\n";
-        tempFile << "发送方姓名: " << userInfo.senderName << "\n";
-        tempFile << "接收方学号: " << userInfo.receiverID << "\n";
-        tempFile << "接收方姓名: " << userInfo.receiverName << "\n";
-        tempFile << "------------------------\n";
+        tempFile << buildUserInfoHeader(userInfo);
 
         // 复制原文件内容
         ifstream inFile(inputFilename, ios::binary);
@@ -358,6 +795,30 @@ public:
     }
     
 
+    void setOutputFormat(OutputFormat format) {
+        outputFormat = format;
+    }
+
+    // 码长上限（如 11-15 位），超出时改用受限码长；0 表示不限制
+    void setMaxCodeLength(int bits) {
+        maxCodeLength = bits;
+    }
+
+    // 容器格式中每 interval 字节写入一个同步点，支持随机访问解压；0 表示关闭
+    void setSyncInterval(uint32_t interval) {
+        syncInterval = interval;
+    }
+
+    // 校验算法（仅容器格式）：CRC32C 并写入块校验表，或兼容旧版本解压程序的 FNV-1a
+    void setChecksumType(uint8_t type) {
+        checksumType = type;
+    }
+
+    // 多字节符号模式（仅容器格式的标准和单遍流水线处理方式）
+    void setSymbolAlphabet(SymbolAlphabet alphabet) {
+        symbolAlphabet = alphabet;
+    }
+
     bool generateCompressedFile(const string& inputFilename) {
         // 构造输出文件名
         string outputFilename = inputFilename;
@@ -384,21 +845,15 @@ public:
         }
 
         
-        // 2. 写入编码后的内容
-        string encodedBits;
-        char byte;
-        while (inFile.get(byte)) {
-            encodedBits += huffmanCodes[static_cast<unsigned char>(byte)];
-            // 当累积的位数足够多时，写入文件
-            if (encodedBits.length() >= 1024) {
-                writeBitsToFile(encodedBits.substr(0, encodedBits.length() - encodedBits.length() % 8), outFile);
-                encodedBits = encodedBits.substr(encodedBits.length() - encodedBits.length() % 8);
-            }
+        // 1. 容器格式先写入头部
+        if (outputFormat == OutputFormat::CONTAINER) {
+            writeContainerPrefix(outFile);
         }
-
-        // 写入剩余的位
-        if (!encodedBits.empty()) {
-            writeBitsToFile(encodedBits, outFile);
+        // 2. 按块读取并查表编码，位流经64位累加器整字写出
+        encodeStream(inFile, &outFile);
+        lastEncodedFile = inputFilename;
+        if (outputFormat == OutputFormat::CONTAINER) {
+            finishContainer(outFile);
         }
 
         inFile.close();
@@ -411,9 +866,26 @@ public:
     }
 
     void generateCodeTable(const string& filename, HuffmanNode* root) {
+        generateCodeTable(getFileSize(filename), root);
+    }
+
+    void generateCodeTable(uint64_t fileSize, HuffmanNode* root) {
         // 生成哈夫曼编码
         huffmanCodes.clear();
         generateCodes(root);
+        applyCodeLengthLimit();
+        bitEncoder = HuffmanBitEncoder();
+        symbolTable = HfmSymbolTable();
+        lastEncodedFile.clear();
+        if (outputFormat == OutputFormat::CONTAINER) {
+            assignCanonicalCodes(fileSize);
+            return;
+        }
+        for (const auto& pair : huffmanCodes) {
+            CodeWord word;
+            codeStringToWord(pair.second, word);
+            bitEncoder.setCode(pair.first, word);
+        }
 
         // 创建编码表文件
         ofstream codeFile("code_bin.txt", ios::binary);
@@ -422,9 +894,12 @@ public:
             return;
         }
 
-        // 写入原文件大小
-        long fileSize = getFileSize(filename);
-        codeFile.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+        // 写入原文件大小（固定4字节小端，与 formatCodeTable 读取一致）
+        unsigned char sizeBytes[4];
+        for (int i = 0; i < 4; i++) {
+            sizeBytes[i] = static_cast<unsigned char>((fileSize >> (i * 8)) & 0xFF);
+        }
+        codeFile.write(reinterpret_cast<const char*>(sizeBytes), 4);
 
         // 写入编码表
         for (const auto& pair : huffmanCodes) {
@@ -467,108 +942,135 @@ public:
     }
 
     // 编码文件并显示最后16个字节
+    // 若该文件刚由 generateCompressedFile 编码过，直接使用那一遍的统计结果
     void encodeAndShowLast16Bytes(const string& filename) {
-        ifstream inFile(filename, ios::binary);
-        if (!inFile) {
-            cerr << "无法打开源文件！" << endl;
-            return;
-        }
-
-        string encodedBits;
-        char byte;
-        while (inFile.get(byte)) {
-            encodedBits += huffmanCodes[static_cast<unsigned char>(byte)];
+        if (filename != lastEncodedFile) {
+            ifstream inFile(filename, ios::binary);
+            if (!inFile) {
+                cerr << "无法打开源文件！" << endl;
+                return;
+            }
+            encodeStream(inFile, nullptr);
+            lastEncodedFile = filename;
         }
-        inFile.close();
-
-        // 转换为字节
-        vector<unsigned char> encodedBytes = binaryStringToBytes(encodedBits);
-        
-        // 计算哈希值
-        uint64_t hash = fnv1a_64(encodedBytes.data(), encodedBytes.size());
 
         // 显示编码信息
         cout << "\n压缩编码信息：" << endl;
-        cout << "总字节数: " << encodedBytes.size() << endl;
-        cout << "压缩后FNV-1a哈希值: 0x" << hex << uppercase << hash << dec << endl;
+        cout << "总字节数: " << lastEncodedSize << endl;
+        printOutputChecksum(lastEncodedChecksum);
 
         // 显示最后16个字节
         cout << "\n压缩后文件的最后16个字节：" << hex << uppercase;
-        size_t start = encodedBytes.size() > 16 ? encodedBytes.size() - 16 : 0;
-        for (size_t i = start; i < encodedBytes.size(); i++) {
+        for (unsigned char b : lastEncodedTail) {
             cout << "0x" << setw(2) << setfill('0') 
-                 << static_cast<int>(encodedBytes[i]) << " ";
+                 << static_cast<int>(b) << " ";
         }
         cout << dec << endl;
     }
 
     // 添加新的文件读取和词频统计方法
-    vector<pair<unsigned char, int>> getFrequenciesFromFile(const string& filename) {
+    vector<pair<unsigned char, uint64_t>> getFrequenciesFromFile(const string& filename) {
         ifstream file(filename, ios::binary);
         if (!file) {
             wcerr << L"无法打开文件: " << filename.c_str() << endl;
             return {};
         }
 
-        // 统计字节频率
-        map<unsigned char, int> freqMap;
-        char byte;
-        while (file.get(byte)) {
-            freqMap[static_cast<unsigned char>(byte)]++;
-        }
-        file.close();
-
-        // 转换为vector
-        vector<pair<unsigned char, int>> frequencies;
-        for (const auto& pair : freqMap) {
-            frequencies.emplace_back(pair.first, pair.second);
+        // 按大块读入，交错直方图统计字节频率
+        uint64_t counts[256] = {};
+        vector<unsigned char> block(1 << 20);
+        while (file) {
+            file.read(reinterpret_cast<char*>(block.data()), block.size());
+            countBytes(block.data(), static_cast<size_t>(file.gcount()), counts);
         }
-
-        return frequencies;
+        return countsToFrequencies(counts);
     }
 
 
-    // 构建哈夫曼树
-    HuffmanNode* buildHuffmanTree(const vector<pair<unsigned char, int>>& frequencies) {
-        
-        heap.clear();
+    // 构建哈夫曼树：叶子按（词频, 字节值）排序后放入第一个队列，合并出的父节点
+    // 词频单调不减，按产生顺序放入第二个队列，每次从两个队首取较小者，O(n) 完成。
+    // 节点从 nodePool 分配，下次建树时整体重用，返回的根节点在下次建树前有效
+    HuffmanNode* buildHuffmanTree(const vector<pair<unsigned char, uint64_t>>& frequencies) {
+        nodePool.clear();
+        if (frequencies.empty()) return nullptr;
+        nodePool.reserve(2 * frequencies.size());
 
-        // 初始化堆
+        vector<HuffmanNode*> leaves;
         for (const auto& pair : frequencies) {
-            insertNode(new HuffmanNode(pair.first, pair.second));
+            nodePool.emplace_back(pair.first, pair.second);
+            leaves.push_back(&nodePool.back());
         }
+        sort(leaves.begin(), leaves.end(), compareNodes);
+
+        vector<HuffmanNode*> merged;
+        merged.reserve(leaves.size());
+        size_t leafHead = 0;
+        size_t mergedHead = 0;
+        auto takeMin = [&]() {
+            if (mergedHead == merged.size() ||
+                (leafHead < leaves.size() && compareNodes(leaves[leafHead], merged[mergedHead]))) {
+                return leaves[leafHead++];
+            }
+            return merged[mergedHead++];
+        };
 
         // 构建哈夫曼树
-        while (heap.size() > 1) {
+        while (leaves.size() - leafHead + merged.size() - mergedHead > 1) {
             // 取出两个最小节点
-            HuffmanNode* left = extractMin();
-            HuffmanNode* right = extractMin();
+            HuffmanNode* left = takeMin();
+            HuffmanNode* right = takeMin();
 
             // 创建新的父节点，使用较大的字节值
-            HuffmanNode* parent = new HuffmanNode(
-                max(left->byte, right->byte),
-                left->frequency + right->frequency
-            );
+            nodePool.emplace_back(max(left->byte, right->byte), left->frequency + right->frequency);
+            HuffmanNode* parent = &nodePool.back();
 
             // 确保频率小的在左边，频率相同时字节值小的在左边
-            if (left->frequency > right->frequency || 
-                (left->frequency == right->frequency && left->byte > right->byte)) {
+            if (compareNodes(right, left)) {
                 swap(left, right);
             }
 
             parent->left = left;
             parent->right = right;
+            merged.push_back(parent);
+        }
+
+        return leafHead < leaves.size() ? leaves[leafHead] : merged[mergedHead];
+    }
 
-            // 使用上滤操作插入新节点
-            insertNode(parent);
+    // 设置了码长上限且哈夫曼码超出时，改用 package-merge 求出的受限码长和规范编码，
+    // 并报告相对最优 WPL 的损失
+    void applyCodeLengthLimit() {
+        if (maxCodeLength <= 0) return;
+        size_t longest = 0;
+        for (const auto& pair : huffmanCodes) longest = max(longest, pair.second.length());
+        if (longest <= static_cast<size_t>(maxCodeLength)) return;
+
+        uint8_t optimal[256] = {};
+        for (const auto& pair : huffmanCodes) optimal[pair.first] = static_cast<uint8_t>(pair.second.length());
+        uint8_t lengths[256];
+        if (!limitedCodeLengths(leafCounts, maxCodeLength, lengths)) {
+            cout << "字节种类过多，无法限制在 " << maxCodeLength << " 位以内，使用原始编码" << endl;
+            return;
+        }
+        uint64_t optimalWpl = codeLengthWpl(leafCounts, optimal);
+        uint64_t limitedWpl = codeLengthWpl(leafCounts, lengths);
+        cout << "\n最长编码 " << longest << " 位，限制为 " << maxCodeLength << " 位" << endl;
+        cout << "最优WPL值：" << optimalWpl << "，限制后WPL值：" << limitedWpl;
+        if (optimalWpl) {
+            cout << "（增加 " << fixed << setprecision(4)
+                 << 100.0 * (limitedWpl - optimalWpl) / optimalWpl << "%）";
         }
+        cout << endl;
 
-        return heap.empty() ? nullptr : heap[0];
+        CodeWord codes[256];
+        canonicalCodes(lengths, codes);
+        for (auto& pair : huffmanCodes) {
+            pair.second = codeWordToString(codes[pair.first]);
+        }
     }
-    
 
     // 计算WPL（加权路径长度）
-    int calculateWPL(HuffmanNode* root, int depth = 0) {
+    uint64_t calculateWPL(HuffmanNode* root, int depth = 0) {
         if (!root) return 0;
         if (!root->left && !root->right) {
             return root->frequency * depth;
@@ -579,11 +1081,11 @@ public:
     
 
     // 打印排序后的词频统计
-    void printFrequencyStats(const vector<pair<unsigned char, int>>& frequencies) {
+    void printFrequencyStats(const vector<pair<unsigned char, uint64_t>>& frequencies) {
         cout << "词频统计列表(按频率排序)：" << endl;
-        vector<pair<unsigned char, int>> sortedFreq = frequencies;
+        vector<pair<unsigned char, uint64_t>> sortedFreq = frequencies;
         sort(sortedFreq.begin(), sortedFreq.end(), 
-            [](const pair<unsigned char, int>& a, const pair<unsigned char, int>& b) {
+            [](const pair<unsigned char, uint64_t>& a, const pair<unsigned char, uint64_t>& b) {
                 if (a.second == b.second) return a.first < b.first;
                 return a.second < b.second;
             });
@@ -595,15 +1097,18 @@ public:
     }
 
      // 添加获取文件大小的方法
-     long getFileSize(const string& filename) {
+     uint64_t getFileSize(const string& filename) {
         ifstream file(filename, ios::binary | ios::ate);
         if (!file) return 0;
-        return file.tellg();
+        return static_cast<uint64_t>(file.tellg());
     }
 
     // 添加计算压缩率的方法
-    double calculateCompressionRatio(const string& filename, int wpl) {
-        long originalSize = getFileSize(filename) * 8; // 原始文件大小（位）
+    double calculateCompressionRatio(const string& filename, uint64_t wpl) {
+        return calculateCompressionRatio(getFileSize(filename), wpl);
+    }
+    double calculateCompressionRatio(uint64_t fileSize, uint64_t wpl) {
+        uint64_t originalSize = fileSize * 8; // 原始文件大小（位）
         if (originalSize == 0) return 0.0;
         return (1.0 - static_cast<double>(wpl) / originalSize) * 100;
     }
@@ -619,20 +1124,19 @@ public:
     
         uint64_t origin_hash = getFileHash(filename);
         // 打印文件基本信息
-        cout << "原始文件哈希值: 0x" << hex << uppercase << setfill('0') 
-         << setw(16) << origin_hash << dec << endl;
+        printChecksum("原始文件哈希值", origin_hash);
         // 创建带有用户信息的新文件
         string processedFile = addUserInfoToFile(filename, userInfo);
         if (processedFile.empty()) {
             cout << "处理文件失败！" << endl;
             return false;
         }
-        // 计算添加信息后的哈希值
-        uint64_t processed_hash = getFileHash(processedFile);
-        cout << "\n添加用户信息后的文件哈希值: 0x" << hex << uppercase << setfill('0') 
-         << setw(16) << processed_hash << dec << endl;
+        // 计算添加信息后的哈希值，同一遍读取得到块校验表
+        ChecksumBuilder processed(activeChecksum(), checksumUnit());
+        checksumFile(processedFile, processed);
+        printChecksum("\n添加用户信息后的文件哈希值", processed.value());
         // 获取词频统计 用于处理后的文件
-        vector<pair<unsigned char, int>> frequencies = getFrequenciesFromFile(processedFile);
+        vector<pair<unsigned char, uint64_t>> frequencies = getFrequenciesFromFile(processedFile);
     
         if (frequencies.empty()) {
             cout << "文件为空或无法读取！" << endl;
@@ -643,7 +1147,7 @@ public:
 
         // 5. 构建哈夫曼树并生成编码
         HuffmanNode* root = buildHuffmanTree(frequencies);
-        int ori_wpl = calculateWPL(root);
+        uint64_t ori_wpl = calculateWPL(root);
         displayCompressionStats(processedFile, ori_wpl);
         // 6. 生成编码表
         generateCodeTable(processedFile, root);
@@ -674,7 +1178,7 @@ public:
             
             // 重新构建哈夫曼树
             root = buildHuffmanTree(frequencies);
-            int ecp_wpl = calculateWPL(root);
+            uint64_t ecp_wpl = calculateWPL(root);
             
             cout << "加密后WPL值：" << ecp_wpl << endl;
             if (ecp_wpl != ori_wpl) {
@@ -689,7 +1193,16 @@ public:
             fileToCompress = encryptedFile;
         }
         
-        // 8. 压缩文件
+        // 8. 多字节符号模式：在待压缩的数据上统计字符，建立符号编码
+        size_t userInfoLength = buildUserInfoHeader(userInfo).size();
+        if (symbolAlphabet != SymbolAlphabet::BYTES && outputFormat == OutputFormat::CONTAINER) {
+            SymbolCounter counter(symbolAlphabet);
+            if (countSymbolsFromFile(fileToCompress, userInfoLength, counter)) {
+                buildSymbolCodes(counter, encType);
+            }
+        }
+        // 9. 压缩文件
+        prepareContainerHeader(encType, userInfoLength, processed, key);
         if (!generateCompressedFile(fileToCompress)) {
             cerr << "生成压缩文件失败！" << endl;
             if (encType != EncryptionType::NONE) {
@@ -698,15 +1211,545 @@ public:
             remove(processedFile.c_str());
             return false;
         }
-        // 9. 显示压缩结果
+        // 10. 显示压缩结果
         encodeAndShowLast16Bytes(fileToCompress);
-        // 10. 清理临时文件
+        // 11. 清理临时文件
         if (encType != EncryptionType::NONE) {
             remove(fileToCompress.c_str());
         }
         remove(processedFile.c_str());
         return true;
     }
+    // 单遍流水线压缩：输出与 compressFile 完全相同，但不写任何临时文件。
+    // 第一遍读取源文件时同时完成头部拼接、加密、两个哈希值和词频统计，
+    // 第二遍读取时直接加密并编码写入 .hfm
+    bool compressFilePipelined(const string& filename, const UserInfo& userInfo,
+        EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY) {
+
+        string header = buildUserInfoHeader(userInfo);
+        vector<unsigned char> block(1 << 22);
+
+        // 第一遍：哈希和块校验值、词频（加密前后），多字节符号模式同时统计待压缩数据中的字符
+        Checksum origin(activeChecksum());
+        ChecksumBuilder processed(activeChecksum(), checksumUnit());
+        uint64_t plainCounts[256] = {};
+        uint64_t encCounts[256] = {};
+        uint64_t processedSize = 0;
+        size_t keyIndex = 0;
+        unique_ptr<SymbolCounter> symbolCounter;
+        if (symbolAlphabet != SymbolAlphabet::BYTES && outputFormat == OutputFormat::CONTAINER) {
+            symbolCounter.reset(new SymbolCounter(symbolAlphabet));
+        }
+        uint64_t symbolOffset = 0;
+        bool ok = scanWithHeader(filename, header, block,
+            [&](unsigned char* data, size_t length, bool isHeader) {
+                if (!isHeader) origin.update(data, length);
+                processed.update(data, length);
+                processedSize += length;
+                countBytes(data, length, plainCounts);
+                if (encType != EncryptionType::NONE) {
+                    encryptBlock(data, length, encType, key, keyIndex);
+                    countBytes(data, length, encCounts);
+                }
+                if (symbolCounter) {
+                    countSymbols(*symbolCounter, data, length, symbolOffset, header.size());
+                }
+            });
+        if (!ok) {
+            cout << "处理文件失败！" << endl;
+            return false;
+        }
+
+        uint64_t fileSize = processedSize;
+        string processedFile = reportAndBuildCodes(filename, fileSize, origin.value(), processed.value(),
+                                                   plainCounts, encCounts, encType);
+        string outputFilename = hfmNameFor(processedFile);
+        if (symbolCounter) {
+            symbolCounter->flush();
+            buildSymbolCodes(*symbolCounter, encType);
+        }
+
+        ofstream outFile(outputFilename, ios::binary);
+        if (!outFile) {
+            cerr << "无法创建压缩文件：" << outputFilename << endl;
+            return false;
+        }
+
+        if (outputFormat == OutputFormat::CONTAINER) {
+            prepareContainerHeader(encType, header.size(), processed, key);
+            writeContainerPrefix(outFile);
+        }
+
+        // 第二遍：加密并编码
+        BitWriter writer(&outFile);
+        writer.setChecksum(activeChecksum());
+        keyIndex = 0;
+        uint64_t offset = 0;
+        ok = scanWithHeader(filename, header, block,
+            [&](unsigned char* data, size_t length, bool) {
+                encryptBlock(data, length, encType, key, keyIndex);
+                encodeChunk(data, length, offset, writer);
+            });
+        finishEncoding(writer);
+        if (outputFormat == OutputFormat::CONTAINER) {
+            finishContainer(outFile);
+        }
+        outFile.close();
+        if (!ok) {
+            cerr << "生成压缩文件失败！" << endl;
+            remove(outputFilename.c_str());
+            return false;
+        }
+        lastEncodedFile = processedFile;
+        lastEncodedSize = writer.bytesWritten();
+        lastEncodedChecksum = writer.outputChecksum();
+        lastEncodedTail = writer.lastBytes();
+
+        cout << "\n压缩文件已生成：" << outputFilename << endl;
+        cout << "压缩文件大小：" << getFileSize(outputFilename) << " 字节" << endl;
+
+        encodeAndShowLast16Bytes(processedFile);
+        return true;
+    }
+    // 分块并行压缩：数据按 blockSize 切成独立编码的块，由线程池统计词频、加密和编码，
+    // 每块起点的位偏移写入块索引，解压时可按块并行。threads 为0时使用全部CPU核心
+    bool compressFileBlocks(const string& filename, const UserInfo& userInfo,
+        EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY,
+        unsigned threads = 0, size_t blockSize = 1 << 20) {
+
+        if (outputFormat != OutputFormat::CONTAINER) {
+            cout << "分块模式需要自描述容器格式，已自动切换" << endl;
+            outputFormat = OutputFormat::CONTAINER;
+        }
+        if (symbolAlphabet != SymbolAlphabet::BYTES) {
+            cout << "分块模式暂不支持多字节符号，使用单字节模式" << endl;
+            symbolAlphabet = SymbolAlphabet::BYTES;
+        }
+        blockSize = max<size_t>(blockSize, 4096);  // 保证用户信息头部位于第一块内
+        string header = buildUserInfoHeader(userInfo);
+        ifstream inFile(filename, ios::binary);
+        if (!inFile) {
+            cout << "处理文件失败！" << endl;
+            return false;
+        }
+        uint64_t processedSize = header.size() + static_cast<uint64_t>(getFileSize(filename));
+
+        ThreadPool pool(threads);
+        cout << "分块并行模式：" << pool.size() << " 个线程，块大小 " << blockSize << " 字节" << endl;
+        size_t blocksPerRound = pool.size() * 4;
+        vector<unsigned char> round(blocksPerRound * blockSize);
+
+        // 第一遍：按顺序计算哈希和块校验值，各块并行统计词频并加密，最后合并
+        Checksum origin(activeChecksum());
+        ChecksumBuilder processed(activeChecksum(), checksumUnit(blockSize));
+        uint64_t plainCounts[256] = {};
+        uint64_t encCounts[256] = {};
+        vector<array<uint64_t, 256>> plainLocal(blocksPerRound);
+        vector<array<uint64_t, 256>> encLocal(blocksPerRound);
+        uint64_t position = 0;
+        while (true) {
+            uint64_t roundStart = position;
+            size_t got = readWithHeader(inFile, header, position, round.data(), round.size());
+            if (got == 0) break;
+            size_t headerPart = roundStart < header.size()
+                ? static_cast<size_t>(min<uint64_t>(got, header.size() - roundStart)) : 0;
+            origin.update(round.data() + headerPart, got - headerPart);
+            processed.update(round.data(), got);
+
+            size_t blocks = (got + blockSize - 1) / blockSize;
+            pool.parallelFor(blocks, [&](size_t k) {
+                unsigned char* data = round.data() + k * blockSize;
+                size_t length = min(blockSize, got - k * blockSize);
+                array<uint64_t, 256>& plain = plainLocal[k];
+                plain.fill(0);
+                countBytes(data, length, plain.data());
+                array<uint64_t, 256>& enc = encLocal[k];
+                enc.fill(0);
+                if (encType != EncryptionType::NONE) {
+                    size_t keyIndex = static_cast<size_t>(roundStart + k * blockSize);
+                    encryptBlock(data, length, encType, key, keyIndex);
+                    countBytes(data, length, enc.data());
+                }
+            });
+            for (size_t k = 0; k < blocks; k++) {
+                for (int b = 0; b < 256; b++) {
+                    plainCounts[b] += plainLocal[k][b];
+                    encCounts[b] += encLocal[k][b];
+                }
+            }
+        }
+        if (position != processedSize) {
+            cout << "处理文件失败！" << endl;
+            return false;
+        }
+
+        uint64_t fileSize = processedSize;
+        string processedFile = reportAndBuildCodes(filename, fileSize, origin.value(), processed.value(),
+                                                   plainCounts, encCounts, encType);
+        string outputFilename = hfmNameFor(processedFile);
+
+        ofstream outFile(outputFilename, ios::binary);
+        if (!outFile) {
+            cerr << "无法创建压缩文件：" << outputFilename << endl;
+            return false;
+        }
+        // 块索引本身即可随机访问，分块模式不写同步点
+        prepareContainerHeader(encType, header.size(), processed, key);
+        containerHeader.flags = HFM_FLAG_BLOCKS | (containerHeader.flags & HFM_FLAG_BLOCK_CHECKSUMS);
+        writeHfmHeader(outFile, containerHeader);
+
+        // 先写入占位的块索引，编码完成后回填；块校验表在第一遍已经算好
+        HfmBlockIndex index;
+        index.blockSize = static_cast<uint32_t>(blockSize);
+        index.bitOffsets.assign((processedSize + blockSize - 1) / blockSize + 1, 0);
+        writeBlockIndex(outFile, index);
+        if (containerHeader.flags & HFM_FLAG_BLOCK_CHECKSUMS) {
+            writeChecksumIndex(outFile, checksumIndex);
+        }
+
+        // 第二遍：各块并行加密并编码到各自的缓冲区，再按顺序写出
+        vector<vector<unsigned char>> encoded(blocksPerRound);
+        inFile.clear();
+        inFile.seekg(0);
+        position = 0;
+        uint64_t bitPosition = 0;
+        size_t blockNo = 0;
+        Checksum payloadChecksum(activeChecksum());
+        vector<unsigned char> tail;
+        while (true) {
+            uint64_t roundStart = position;
+            size_t got = readWithHeader(inFile, header, position, round.data(), round.size());
+            if (got == 0) break;
+            size_t blocks = (got + blockSize - 1) / blockSize;
+            if (blockNo + blocks > index.blockCount()) break;
+            pool.parallelFor(blocks, [&](size_t k) {
+                unsigned char* data = round.data() + k * blockSize;
+                size_t length = min(blockSize, got - k * blockSize);
+                size_t keyIndex = static_cast<size_t>(roundStart + k * blockSize);
+                encryptBlock(data, length, encType, key, keyIndex);
+                encoded[k].clear();
+                BitWriter writer(encoded[k]);
+                bitEncoder.encode(data, length, writer);
+                writer.finish();
+            });
+            for (size_t k = 0; k < blocks; k++) {
+                const vector<unsigned char>& bytes = encoded[k];
+                index.bitOffsets[blockNo++] = bitPosition;
+                outFile.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+                bitPosition += bytes.size() * 8;
+                payloadChecksum.update(bytes.data(), bytes.size());
+                tail.insert(tail.end(), bytes.size() > 16 ? bytes.end() - 16 : bytes.begin(), bytes.end());
+                if (tail.size() > 16) tail.erase(tail.begin(), tail.end() - 16);
+            }
+        }
+        if (position != processedSize || blockNo != index.blockCount()) {
+            cerr << "生成压缩文件失败！" << endl;
+            outFile.close();
+            remove(outputFilename.c_str());
+            return false;
+        }
+        index.bitOffsets[blockNo] = bitPosition;
+        outFile.seekp(static_cast<streamoff>(HFM_HEADER_SIZE));
+        writeBlockIndex(outFile, index);
+        outFile.close();
+
+        lastEncodedFile = processedFile;
+        lastEncodedSize = bitPosition / 8;
+        lastEncodedChecksum = payloadChecksum.value();
+        lastEncodedTail = tail;
+
+        cout << "\n压缩文件已生成：" << outputFilename << endl;
+        cout << "压缩文件大小：" << getFileSize(outputFilename) << " 字节" << endl;
+        cout << "块数：" << index.blockCount() << endl;
+
+        encodeAndShowLast16Bytes(processedFile);
+        return true;
+    }
+
+    // 流式压缩：源数据从任意输入流分段读入，经 HuffmanStreamEncoder 的固定缓冲区编码写出，
+    // 内存占用与数据大小无关。tableFile 为已有的 .hfm 容器时直接使用其编码表，单遍完成，
+    // 输入可以是管道；为空时先读一遍统计词频再回到开头编码，输入必须可以回退
+    bool compressStream(istream& in, const string& outputFilename, const UserInfo& userInfo,
+        EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY,
+        const string& tableFile = "") {
+
+        if (outputFormat != OutputFormat::CONTAINER) {
+            cout << "流式模式需要自描述容器格式，已自动切换" << endl;
+            outputFormat = OutputFormat::CONTAINER;
+        }
+        if (symbolAlphabet != SymbolAlphabet::BYTES) {
+            cout << "流式模式暂不支持多字节符号，使用单字节模式" << endl;
+            symbolAlphabet = SymbolAlphabet::BYTES;
+        }
+        if (syncInterval) {
+            cout << "流式模式不写入同步点索引，已忽略同步点设置" << endl;
+            syncInterval = 0;
+        }
+        string header = buildUserInfoHeader(userInfo);
+        vector<unsigned char> block(1 << 16);
+        vector<unsigned char> encoded(1 << 16);
+        // 只有先扫描一遍时才预先知道数据长度，能在位流之前写出块校验表
+        unique_ptr<ChecksumBuilder> firstPass;
+        uint64_t firstPassSize = 0;
+
+        if (!tableFile.empty()) {
+            ifstream tableIn(tableFile, ios::binary);
+            HfmHeader source;
+            if (!tableIn || !readHfmHeader(tableIn, source)) {
+                cerr << "无法从 " << tableFile << " 读取编码表！" << endl;
+                return false;
+            }
+            memcpy(containerHeader.codeLengths, source.codeLengths, sizeof(source.codeLengths));
+            int covered = static_cast<int>(count_if(begin(source.codeLengths), end(source.codeLengths),
+                                                    [](uint8_t length) { return length != 0; }));
+            cout << "使用 " << tableFile << " 的编码表，覆盖 " << covered << " 个字节值" << endl;
+            if (covered < 256) {
+                cout << "警告：遇到编码表中没有的字节时压缩将失败" << endl;
+            }
+        } else {
+            // 第一遍：统计加密后的词频
+            streampos start = in.tellg();
+            if (start == streampos(-1)) {
+                cerr << "输入流不支持回退，请提供编码表文件！" << endl;
+                return false;
+            }
+            uint64_t counts[256] = {};
+            uint64_t processedSize = header.size();
+            size_t keyIndex = 0;
+            firstPass.reset(new ChecksumBuilder(activeChecksum(), checksumUnit()));
+            vector<unsigned char> headerBytes(header.begin(), header.end());
+            firstPass->update(headerBytes.data(), headerBytes.size());
+            encryptBlock(headerBytes.data(), headerBytes.size(), encType, key, keyIndex);
+            countBytes(headerBytes.data(), headerBytes.size(), counts);
+            while (in) {
+                in.read(reinterpret_cast<char*>(block.data()), block.size());
+                size_t got = static_cast<size_t>(in.gcount());
+                firstPass->update(block.data(), got);
+                encryptBlock(block.data(), got, encType, key, keyIndex);
+                countBytes(block.data(), got, counts);
+                processedSize += got;
+            }
+            HuffmanNode* root = buildHuffmanTree(countsToFrequencies(counts));
+            generateCodeTable(processedSize, root);
+            firstPassSize = processedSize;
+            in.clear();
+            in.seekg(start);
+        }
+
+        ofstream outFile(outputFilename, ios::binary);
+        if (!outFile) {
+            cerr << "无法创建压缩文件：" << outputFilename << endl;
+            return false;
+        }
+        // 原始长度和哈希值在编码结束后回填，先写占位头部
+        containerHeader.encryption = static_cast<uint8_t>(encType);
+        containerHeader.userInfoLength = static_cast<uint32_t>(header.size());
+        containerHeader.checksum = activeChecksum();
+        containerHeader.flags = 0;
+        checksumIndex = firstPass ? firstPass->finish() : HfmChecksumIndex();
+        if (checksumIndex.unit) {
+            containerHeader.flags |= HFM_FLAG_BLOCK_CHECKSUMS;
+            containerHeader.originalSize = firstPassSize;
+        }
+        writeHfmHeader(outFile, containerHeader);
+        if (checksumIndex.unit) writeChecksumIndex(outFile, checksumIndex);
+
+        HuffmanStreamEncoder encoder(containerHeader.codeLengths);
+        encoder.setOutputChecksum(activeChecksum());
+        Checksum origin(activeChecksum());
+        Checksum processed(activeChecksum());
+        size_t keyIndex = 0;
+        auto push = [&](unsigned char* data, size_t length) {
+            processed.update(data, length);
+            encryptBlock(data, length, encType, key, keyIndex);
+            while (length > 0 && encoder.ok()) {
+                size_t accepted = encoder.feed(data, length);
+                data += accepted;
+                length -= accepted;
+                size_t n;
+                while ((n = encoder.read(encoded.data(), encoded.size())) > 0) {
+                    outFile.write(reinterpret_cast<const char*>(encoded.data()), n);
+                }
+            }
+        };
+
+        vector<unsigned char> headerBytes(header.begin(), header.end());
+        push(headerBytes.data(), headerBytes.size());
+        while (in && encoder.ok()) {
+            in.read(reinterpret_cast<char*>(block.data()), block.size());
+            size_t got = static_cast<size_t>(in.gcount());
+            origin.update(block.data(), got);
+            push(block.data(), got);
+        }
+        encoder.finish();
+        size_t n;
+        while ((n = encoder.read(encoded.data(), encoded.size())) > 0) {
+            outFile.write(reinterpret_cast<const char*>(encoded.data()), n);
+        }
+        if (!encoder.ok()) {
+            cerr << "输入中出现编码表未包含的字节，压缩失败！" << endl;
+            outFile.close();
+            remove(outputFilename.c_str());
+            return false;
+        }
+
+        // 块校验表来自第一遍，源数据在两遍之间变化时与位流不符
+        if (firstPass && (encoder.bytesIn() != firstPassSize || processed.value() != firstPass->value())) {
+            cerr << "源文件在两遍读取之间发生了变化，压缩失败！" << endl;
+            outFile.close();
+            remove(outputFilename.c_str());
+            return false;
+        }
+        containerHeader.originalSize = encoder.bytesIn();
+        containerHeader.dataHash = processed.value();
+        outFile.seekp(0);
+        writeHfmHeader(outFile, containerHeader);
+        outFile.close();
+
+        printChecksum("原始数据哈希值", origin.value());
+        printChecksum("添加用户信息后的哈希值", processed.value());
+        if (checksumIndex.unit) {
+            cout << "块校验表：" << checksumIndex.checksums.size() << " 项，每项 " << checksumIndex.unit << " 字节" << endl;
+        }
+        cout << "\n压缩文件已生成：" << outputFilename << endl;
+        cout << "原始数据大小：" << encoder.bytesIn() << " 字节" << endl;
+        cout << "压缩后位流大小：" << encoder.bytesOut() << " 字节" << endl;
+        printOutputChecksum(encoder.outputChecksum());
+        return true;
+    }
+
+    // 批量归档：把目录下的全部文件（或列表文件中逐行给出的文件）压缩成一个 .hfa，
+    // 用户信息头部只存一份。共享编码表从 tableFile 加载，或在按间隔抽取的样本文件上训练，
+    // 训练结果可保存到 saveTable 供以后的归档直接加载；每个成员用共享编码表和自带私有编码表中
+    // 较小的一种。各成员由线程池并行读取、加密和编码，按输入顺序写出。threads 为0时使用全部CPU核心
+    bool compressArchive(const string& inputPath, const UserInfo& userInfo,
+        EncryptionType encType = EncryptionType::NONE, const string& key = DEFAULT_KEY,
+        unsigned threads = 0, bool useSharedTable = true, const string& tableFile = "",
+        const string& saveTable = "") {
+
+        if (symbolAlphabet != SymbolAlphabet::BYTES) {
+            cout << "批量归档暂不支持多字节符号，使用单字节模式" << endl;
+            symbolAlphabet = SymbolAlphabet::BYTES;
+        }
+        vector<string> files;
+        vector<string> names;
+        if (!collectArchiveInputs(inputPath, files, names)) return false;
+        string archivePath = archiveNameFor(inputPath);
+        auto startTime = chrono::steady_clock::now();
+        ThreadPool pool(threads);
+        const int maxLength = maxCodeLength > 0 ? maxCodeLength : HFM_MAX_CODE_LENGTH;
+        cout << "批量归档：" << files.size() << " 个文件，" << pool.size() << " 个线程" << endl;
+
+        // 共享编码表：加载已训练的，或在样本上训练
+        HfaSharedTable shared;
+        if (!tableFile.empty()) {
+            uint8_t lengths[256];
+            if (!readCodeTableFile(tableFile, lengths) || !shared.build(lengths)) {
+                cerr << "无法从 " << tableFile << " 读取共享编码表！" << endl;
+                return false;
+            }
+            int covered = static_cast<int>(count_if(begin(lengths), end(lengths),
+                                                    [](uint8_t length) { return length != 0; }));
+            cout << "使用 " << tableFile << " 的共享编码表，覆盖 " << covered << " 个字节值" << endl;
+        } else if (useSharedTable) {
+            if (!trainSharedTable(files, pool, encType, key, maxLength, shared)) return false;
+            if (!saveTable.empty()) {
+                if (writeCodeTableFile(saveTable, shared.lengths)) {
+                    cout << "共享编码表已保存到 " << saveTable << endl;
+                } else {
+                    cerr << "无法保存共享编码表：" << saveTable << endl;
+                }
+            }
+        }
+
+        ofstream outFile(archivePath, ios::binary);
+        if (!outFile) {
+            cerr << "无法创建归档文件：" << archivePath << endl;
+            return false;
+        }
+        // 目录偏移在写完所有记录后回填
+        HfaHeader header;
+        header.encryption = static_cast<uint8_t>(encType);
+        header.flags = shared.present ? HFA_FLAG_SHARED_TABLE : 0;
+        header.memberCount = static_cast<uint32_t>(files.size());
+        memcpy(header.sharedLengths, shared.lengths, sizeof(shared.lengths));
+        writeHfaHeader(outFile, header);
+
+        vector<HfaEntry> entries(files.size() + 1);
+        uint64_t offset = HFA_HEADER_SIZE;
+        auto append = [&](HfaEntry& entry, const vector<unsigned char>& record) {
+            entry.offset = offset;
+            entry.length = record.size();
+            outFile.write(reinterpret_cast<const char*>(record.data()), record.size());
+            offset += record.size();
+        };
+
+        // 第0条记录：用户信息头部
+        string userHeader = buildUserInfoHeader(userInfo);
+        vector<unsigned char> headerData(userHeader.begin(), userHeader.end());
+        vector<unsigned char> headerRecord;
+        entries[0].originalSize = headerData.size();
+        entries[0].crc = crc32cUpdate(0, headerData.data(), headerData.size());
+        size_t keyIndex = 0;
+        encryptBlock(headerData.data(), headerData.size(), encType, key, keyIndex);
+        entries[0].table = encodeArchiveRecord(headerData.data(), headerData.size(), shared, maxLength, headerRecord);
+        append(entries[0], headerRecord);
+
+        // 各成员按轮并行编码到各自的缓冲区，再按顺序写出
+        const size_t perRound = pool.size() * 8;
+        vector<vector<unsigned char>> records(perRound);
+        vector<char> loaded(perRound);
+        uint64_t totalSize = 0;
+        size_t sharedCount = 0;
+        for (size_t first = 0; first < files.size(); first += perRound) {
+            size_t count = min(perRound, files.size() - first);
+            pool.parallelFor(count, [&](size_t k) {
+                HfaEntry& entry = entries[first + k + 1];
+                vector<unsigned char> data;
+                loaded[k] = loadArchiveMember(files[first + k], encType, key, data, entry.crc);
+                if (!loaded[k]) return;
+                entry.name = names[first + k];
+                entry.originalSize = data.size();
+                entry.table = encodeArchiveRecord(data.data(), data.size(), shared, maxLength, records[k]);
+            });
+            for (size_t k = 0; k < count; k++) {
+                if (!loaded[k]) {
+                    cerr << "无法读取文件：" << files[first + k] << endl;
+                    outFile.close();
+                    remove(archivePath.c_str());
+                    return false;
+                }
+                HfaEntry& entry = entries[first + k + 1];
+                append(entry, records[k]);
+                totalSize += entry.originalSize;
+                if (entry.table == HFA_TABLE_SHARED) sharedCount++;
+            }
+        }
+
+        header.directoryOffset = offset;
+        writeHfaDirectory(outFile, entries);
+        outFile.seekp(0);
+        writeHfaHeader(outFile, header);
+        outFile.close();
+        if (!outFile) {
+            cerr << "写入归档文件失败！" << endl;
+            remove(archivePath.c_str());
+            return false;
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        uint64_t archiveSize = getFileSize(archivePath);
+        cout << "\n归档文件已生成：" << archivePath << endl;
+        cout << "成员数：" << files.size() << "（共享编码表 " << sharedCount << " 个，私有编码表 "
+             << files.size() - sharedCount << " 个）" << endl;
+        cout << "原始总大小：" << totalSize << " 字节" << endl;
+        cout << "归档文件大小：" << archiveSize << " 字节" << endl;
+        cout << "压缩率：" << fixed << setprecision(2) << calculateCompressionRatio(totalSize, archiveSize * 8)
+             << "%" << endl;
+        cout << "耗时：" << setprecision(6) << seconds << " 秒，每秒 " << setprecision(1)
+             << (seconds > 0 ? files.size() / seconds : 0.0) << " 个文件" << endl;
+        return true;
+    }
 };
 
 
@@ -719,7 +1762,7 @@ int main() {
     UserInfo userInfo;
     char choice;
     //1. 读取文件路径
-    cout << "请输入要压缩的文件路径: ";
+    cout << "请输入要压缩的文件路径（批量归档时为目录或文件列表）: ";
     std::getline(cin, filename);
   
     //2. 读取用户信息
@@ -764,9 +1807,127 @@ int main() {
         default:
             encType = EncryptionType::NONE;
     }
-    // 4. 执行压缩处理
-    if (!huffman.compressFile(filename, userInfo, encType,
-    customKey.empty() ? DEFAULT_KEY : customKey)) {
+    // 4. 选择输出格式
+    cout << "\n请选择输出格式：" << endl;
+    cout << "0. 自描述容器（编码表写入 .hfm，默认）" << endl;
+    cout << "1. 旧格式（编码表写入 code.txt）" << endl;
+    cout << "请输入选择 (0-1): ";
+    string formatChoice;
+    getline(cin, formatChoice);
+    if (formatChoice == "1") {
+        huffman.setOutputFormat(OutputFormat::LEGACY_CODE_TABLE);
+    }
+
+    // 同步点索引（仅容器格式）
+    if (formatChoice != "1") {
+        cout << "\n是否写入同步点索引以支持随机访问解压？(Y/N，默认N): ";
+        string syncChoice;
+        getline(cin, syncChoice);
+        if (!syncChoice.empty() && toupper(syncChoice[0]) == 'Y') {
+            huffman.setSyncInterval(64 * 1024);
+        }
+
+        cout << "\n请选择符号模式：" << endl;
+        cout << "0. 单字节（默认）" << endl;
+        cout << "1. UTF-8 多字节字符（适合中文文本）" << endl;
+        cout << "2. GBK 多字节字符" << endl;
+        cout << "请输入选择 (0-2): ";
+        string symbolChoice;
+        getline(cin, symbolChoice);
+        if (symbolChoice == "1") {
+            huffman.setSymbolAlphabet(SymbolAlphabet::UTF8);
+        } else if (symbolChoice == "2") {
+            huffman.setSymbolAlphabet(SymbolAlphabet::GBK);
+        }
+
+        cout << "\n请选择校验算法：" << endl;
+        cout << "0. CRC32C，并写入块校验表，解压时逐块校验（默认）" << endl;
+        cout << "1. FNV-1a（兼容旧版本解压程序）" << endl;
+        cout << "请输入选择 (0-1): ";
+        string checksumChoice;
+        getline(cin, checksumChoice);
+        if (checksumChoice == "1") {
+            huffman.setChecksumType(HFM_CHECKSUM_FNV1A);
+        }
+    }
+
+    // 5. 选择处理方式
+    cout << "\n请选择处理方式：" << endl;
+    cout << "0. 标准（生成临时文件，默认）" << endl;
+    cout << "1. 单遍流水线（不生成临时文件）" << endl;
+    cout << "2. 分块并行（多线程，需容器格式）" << endl;
+    cout << "3. 流式（固定内存，源文件可以是管道）" << endl;
+    cout << "4. 批量归档（目录或文件列表，多个小文件共用编码表）" << endl;
+    cout << "请输入选择 (0-4): ";
+    string modeChoice;
+    getline(cin, modeChoice);
+    unsigned threads = 0;
+    if (modeChoice == "2" || modeChoice == "4") {
+        cout << "请输入线程数（0 表示使用全部CPU核心）: ";
+        string threadInput;
+        getline(cin, threadInput);
+        if (!parseThreadCount(threadInput, threads)) {
+            cout << "线程数无效，使用全部CPU核心" << endl;
+        }
+    }
+    string tableFile;
+    if (modeChoice == "3") {
+        cout << "请输入提供编码表的 .hfm 文件（留空则先扫描一遍源文件）: ";
+        getline(cin, tableFile);
+    }
+    bool useSharedTable = true;
+    string saveTable;
+    if (modeChoice == "4") {
+        cout << "\n请选择共享编码表：" << endl;
+        cout << "0. 在样本文件上训练（默认）" << endl;
+        cout << "1. 加载已训练的编码表（.hft，或单字节模式的 .hfm、.hfa）" << endl;
+        cout << "2. 不使用，每个文件自带编码表" << endl;
+        cout << "请输入选择 (0-2): ";
+        string tableChoice;
+        getline(cin, tableChoice);
+        if (tableChoice == "1") {
+            cout << "请输入编码表文件: ";
+            getline(cin, tableFile);
+        } else if (tableChoice == "2") {
+            useSharedTable = false;
+        } else {
+            cout << "保存训练得到的编码表到文件（如 shared.hft，留空不保存）: ";
+            getline(cin, saveTable);
+        }
+    }
+
+    cout << "请输入最大码长（如 11-15，留空不限制）: ";
+    string lengthInput;
+    getline(cin, lengthInput);
+    if (!lengthInput.empty()) {
+        char* end = nullptr;
+        long bits = strtol(lengthInput.c_str(), &end, 10);
+        if (*end == '\0' && bits >= 1 && bits <= HFM_MAX_CODE_LENGTH) {
+            huffman.setMaxCodeLength(static_cast<int>(bits));
+        } else {
+            cout << "码长上限无效，不限制码长" << endl;
+        }
+    }
+
+    // 6. 执行压缩处理
+    const string& useKey = customKey.empty() ? DEFAULT_KEY : customKey;
+    bool success;
+    if (modeChoice == "4") {
+        success = huffman.compressArchive(filename, userInfo, encType, useKey, threads, useSharedTable,
+                                          tableFile, saveTable);
+    } else if (modeChoice == "3") {
+        ifstream source(filename, ios::binary);
+        string outputName = filename.substr(0, filename.find_last_of('.')) + "_added"
+                          + (encType == EncryptionType::NONE ? "" : "_ecp") + ".hfm";
+        success = source && huffman.compressStream(source, outputName, userInfo, encType, useKey, tableFile);
+    } else if (modeChoice == "2") {
+        success = huffman.compressFileBlocks(filename, userInfo, encType, useKey, threads);
+    } else if (modeChoice == "1") {
+        success = huffman.compressFilePipelined(filename, userInfo, encType, useKey);
+    } else {
+        success = huffman.compressFile(filename, userInfo, encType, useKey);
+    }
+    if (!success) {
         return 1;
     }
 
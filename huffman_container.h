@@ -0,0 +1,349 @@
+#ifndef HUFFMAN_CONTAINER_H
+#define HUFFMAN_CONTAINER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "huffman_bits.h"
+
+// 自描述 .hfm 容器（第1版），所有整数均为小端序：
+//   偏移  长度  内容
+//   0     4     魔数 "HFMC"
+//   4     1     版本号
+//   5     1     加密方式（0 不加密，1 偏移，2 XOR）
+//   6     2     标志位，见 HFM_FLAG_*
+//   8     8     原始数据长度（含用户信息头部）
+//   16    4     用户信息头部长度
+//   20    1     校验算法，见 HFM_CHECKSUM_*（旧文件为0，即 FNV-1a）
+//   21    3     保留为0
+//   24    8     原始数据的校验值（CRC32C 只用低32位）
+//   32    256   每个字节值的规范哈夫曼编码长度，0 表示未出现
+//   288   ...   编码后的位流
+// 设置 HFM_FLAG_BLOCKS 时，头部之后先是块索引，再是位流：
+//   4     块大小（原始数据字节数，最后一块可能较短）
+//   4     块数 n
+//   8*(n+1)  每块起点相对位流开头的位偏移，最后一项为位流总位数
+// 每块从字节边界开始独立编码，可以并行压缩和解压
+// 设置 HFM_FLAG_SYNC_POINTS 时（位于块索引之后）为同步点索引：
+//   4     同步间隔 N（原始数据字节数）
+//   4     同步点数 m，第 i 个同步点对应原始数据偏移 i*N
+//   12*m  每个同步点：8 字节位偏移（相对位流开头）+ 4 字节 XOR 密钥下标
+// 从同步点开始解码即可随机访问，无需解码之前的全部数据
+// 设置 HFM_FLAG_BLOCK_CHECKSUMS 时（位于同步点索引之后）为块校验表：
+//   4     校验单元大小 N（原始数据字节数）
+//   4     单元数 k，第 i 个单元为原始数据 [i*N, (i+1)*N)
+//   4*k   每个单元的 CRC32C
+// 解码时每完成一个单元即可比对，第一个损坏的单元处停止，不必等到整个文件解完
+// 设置 HFM_FLAG_SYMBOLS 时（位于以上索引之后）为多字节符号表，格式见 huffman_symbols.h。
+// 此时头部的256个码长只是单字节符号的码长，整张编码表还包括符号表中的多字节字符
+const char HFM_MAGIC[4] = {'H', 'F', 'M', 'C'};
+const uint8_t HFM_VERSION = 1;
+const size_t HFM_HEADER_SIZE = 288;
+const int HFM_MAX_CODE_LENGTH = 63;
+const uint16_t HFM_FLAG_BLOCKS = 0x0001;
+const uint16_t HFM_FLAG_SYNC_POINTS = 0x0002;
+const uint16_t HFM_FLAG_SYMBOLS = 0x0004;
+const uint16_t HFM_FLAG_BLOCK_CHECKSUMS = 0x0008;
+const uint16_t HFM_KNOWN_FLAGS = HFM_FLAG_BLOCKS | HFM_FLAG_SYNC_POINTS | HFM_FLAG_SYMBOLS |
+                                 HFM_FLAG_BLOCK_CHECKSUMS;
+
+struct HfmHeader {
+    uint8_t version = HFM_VERSION;
+    uint8_t encryption = 0;
+    uint16_t flags = 0;
+    uint64_t originalSize = 0;
+    uint32_t userInfoLength = 0;
+    uint8_t checksum = HFM_CHECKSUM_FNV1A;
+    uint64_t dataHash = 0;
+    uint8_t codeLengths[256] = {};
+};
+
+inline void putLE(unsigned char* p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+inline uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+// 由码长生成规范哈夫曼编码：码长短的在前，同长度按符号编号（字节值）递增编号。
+// 码长不满足前缀码条件（Kraft 不等式）时返回 false
+inline bool canonicalCodes(const uint8_t* lengths, size_t count, CodeWord* codes) {
+    uint64_t lengthCount[HFM_MAX_CODE_LENGTH + 1] = {};
+    for (size_t s = 0; s < count; s++) {
+        if (lengths[s] > HFM_MAX_CODE_LENGTH) return false;
+        if (lengths[s]) lengthCount[lengths[s]]++;
+    }
+    uint64_t nextCode[HFM_MAX_CODE_LENGTH + 1] = {};
+    uint64_t code = 0;
+    for (int len = 1; len <= HFM_MAX_CODE_LENGTH; len++) {
+        code = (code + lengthCount[len - 1]) << 1;
+        if (code + lengthCount[len] > (uint64_t(1) << len)) return false;
+        nextCode[len] = code;
+    }
+    for (size_t s = 0; s < count; s++) {
+        codes[s] = CodeWord();
+        if (lengths[s]) {
+            codes[s].bits = nextCode[lengths[s]]++;
+            codes[s].length = lengths[s];
+        }
+    }
+    return true;
+}
+
+inline bool canonicalCodes(const uint8_t lengths[256], CodeWord codes[256]) {
+    return canonicalCodes(lengths, 256, codes);
+}
+
+// 规范编码转为解码器需要的 (字节, 编码) 列表
+inline std::vector<std::pair<unsigned char, CodeWord>> codeListFromLengths(const uint8_t lengths[256]) {
+    std::vector<std::pair<unsigned char, CodeWord>> list;
+    CodeWord codes[256];
+    if (!canonicalCodes(lengths, codes)) return list;
+    for (int b = 0; b < 256; b++) {
+        if (codes[b].length) list.emplace_back(static_cast<unsigned char>(b), codes[b]);
+    }
+    return list;
+}
+
+inline bool writeHfmHeader(std::ostream& out, const HfmHeader& header) {
+    unsigned char buf[HFM_HEADER_SIZE] = {};
+    std::memcpy(buf, HFM_MAGIC, 4);
+    buf[4] = header.version;
+    buf[5] = header.encryption;
+    putLE(buf + 6, header.flags, 2);
+    putLE(buf + 8, header.originalSize, 8);
+    putLE(buf + 16, header.userInfoLength, 4);
+    buf[20] = header.checksum;
+    putLE(buf + 24, header.dataHash, 8);
+    std::memcpy(buf + 32, header.codeLengths, 256);
+    out.write(reinterpret_cast<const char*>(buf), HFM_HEADER_SIZE);
+    return static_cast<bool>(out);
+}
+
+// 判断输入流是否以容器魔数开头，不改变读取位置
+inline bool isHfmContainer(std::istream& in) {
+    std::streampos pos = in.tellg();
+    char magic[4] = {};
+    in.read(magic, 4);
+    bool result = in.gcount() == 4 && std::memcmp(magic, HFM_MAGIC, 4) == 0;
+    in.clear();
+    in.seekg(pos);
+    return result;
+}
+
+// 读取并校验容器头部，成功后读取位置停在位流起点
+inline bool readHfmHeader(std::istream& in, HfmHeader& header) {
+    unsigned char buf[HFM_HEADER_SIZE];
+    in.read(reinterpret_cast<char*>(buf), HFM_HEADER_SIZE);
+    if (in.gcount() != static_cast<std::streamsize>(HFM_HEADER_SIZE)) return false;
+    if (std::memcmp(buf, HFM_MAGIC, 4) != 0) return false;
+    header.version = buf[4];
+    if (header.version != HFM_VERSION) return false;
+    header.encryption = buf[5];
+    if (header.encryption > 2) return false;
+    header.flags = static_cast<uint16_t>(getLE(buf + 6, 2));
+    if (header.flags & ~HFM_KNOWN_FLAGS) return false;
+    header.originalSize = getLE(buf + 8, 8);
+    header.userInfoLength = static_cast<uint32_t>(getLE(buf + 16, 4));
+    header.checksum = buf[20];
+    if (header.checksum > HFM_CHECKSUM_CRC32C) return false;
+    if (header.checksum != HFM_CHECKSUM_CRC32C && (header.flags & HFM_FLAG_BLOCK_CHECKSUMS)) return false;
+    header.dataHash = getLE(buf + 24, 8);
+    std::memcpy(header.codeLengths, buf + 32, 256);
+    CodeWord codes[256];
+    return canonicalCodes(header.codeLengths, codes);
+}
+
+// 分块模式的块索引
+struct HfmBlockIndex {
+    uint32_t blockSize = 0;
+    std::vector<uint64_t> bitOffsets;  // 块数 + 1 项
+
+    size_t blockCount() const { return bitOffsets.empty() ? 0 : bitOffsets.size() - 1; }
+    // 块索引在文件中占用的字节数
+    size_t byteSize() const { return 8 + 8 * bitOffsets.size(); }
+};
+
+inline bool writeBlockIndex(std::ostream& out, const HfmBlockIndex& index) {
+    std::vector<unsigned char> buf(index.byteSize());
+    putLE(buf.data(), index.blockSize, 4);
+    putLE(buf.data() + 4, index.blockCount(), 4);
+    for (size_t i = 0; i < index.bitOffsets.size(); i++) {
+        putLE(buf.data() + 8 + 8 * i, index.bitOffsets[i], 8);
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return static_cast<bool>(out);
+}
+
+// 读取 count 项、每项 entrySize 字节的索引表。count 来自文件本身，不可信，所以分段读取，
+// 分配的内存随实际读到的数据增长；输入也可能是管道，不能预先查询剩余长度。数据不足时返回 false
+inline bool readIndexEntries(std::istream& in, uint64_t count, size_t entrySize, std::vector<unsigned char>& buf) {
+    const uint64_t chunk = (1 << 20) / entrySize;
+    buf.clear();
+    for (uint64_t done = 0; done < count;) {
+        size_t n = static_cast<size_t>(std::min(count - done, chunk));
+        size_t old = buf.size();
+        buf.resize(old + n * entrySize);
+        in.read(reinterpret_cast<char*>(buf.data() + old), static_cast<std::streamsize>(n * entrySize));
+        if (in.gcount() != static_cast<std::streamsize>(n * entrySize)) return false;
+        done += n;
+    }
+    return true;
+}
+
+// 可定位的输入流从当前读取位置到末尾的字节数，读取位置不变
+inline uint64_t streamBytesLeft(std::istream& in) {
+    std::streampos here = in.tellg();
+    if (here < 0) return 0;
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(here);
+    return end > here ? static_cast<uint64_t>(end - here) : 0;
+}
+
+// 读取块索引并检查与头部记录的原始长度一致。available 为块索引起点到文件末尾的字节数，
+// 位流就在其中：第一块须从位流开头开始，最后的偏移不能超出文件，且每块的位数不少于
+// 其中的符号数（每个符号至少1位），否则索引已损坏，不按其中的数值分配内存
+inline bool readBlockIndex(std::istream& in, const HfmHeader& header, HfmBlockIndex& index, uint64_t available) {
+    unsigned char head[8];
+    in.read(reinterpret_cast<char*>(head), 8);
+    if (in.gcount() != 8) return false;
+    index.blockSize = static_cast<uint32_t>(getLE(head, 4));
+    uint64_t count = getLE(head + 4, 4);
+    if (index.blockSize == 0) return false;
+    if (count != (header.originalSize + index.blockSize - 1) / index.blockSize) return false;
+    if (available < 8 + 8 * (count + 1)) return false;
+    const uint64_t payloadBytes = available - 8 - 8 * (count + 1);
+
+    std::vector<unsigned char> buf;
+    if (!readIndexEntries(in, count + 1, 8, buf)) return false;
+    index.bitOffsets.resize(count + 1);
+    for (size_t i = 0; i <= count; i++) {
+        index.bitOffsets[i] = getLE(buf.data() + 8 * i, 8);
+        if (i == 0) {
+            if (index.bitOffsets[0] != 0) return false;
+            continue;
+        }
+        uint64_t bits = index.bitOffsets[i] - index.bitOffsets[i - 1];
+        uint64_t symbols = std::min<uint64_t>(index.blockSize, header.originalSize - (i - 1) * index.blockSize);
+        if (index.bitOffsets[i] < index.bitOffsets[i - 1] || bits < symbols) return false;
+    }
+    return (index.bitOffsets[count] + 7) / 8 <= payloadBytes;
+}
+
+// 同步点：原始数据中某个偏移处的符号在位流中的起始位置
+struct HfmSyncPoint {
+    uint64_t bitOffset = 0;
+    uint32_t keyIndex = 0;  // 该处使用的 XOR 密钥下标，未加密时为0
+};
+
+struct HfmSyncIndex {
+    uint32_t interval = 0;
+    std::vector<HfmSyncPoint> points;
+
+    size_t byteSize() const { return 8 + 12 * points.size(); }
+};
+
+inline bool writeSyncIndex(std::ostream& out, const HfmSyncIndex& index) {
+    std::vector<unsigned char> buf(index.byteSize());
+    putLE(buf.data(), index.interval, 4);
+    putLE(buf.data() + 4, index.points.size(), 4);
+    for (size_t i = 0; i < index.points.size(); i++) {
+        putLE(buf.data() + 8 + 12 * i, index.points[i].bitOffset, 8);
+        putLE(buf.data() + 16 + 12 * i, index.points[i].keyIndex, 4);
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return static_cast<bool>(out);
+}
+
+inline bool readSyncIndex(std::istream& in, const HfmHeader& header, HfmSyncIndex& index) {
+    unsigned char head[8];
+    in.read(reinterpret_cast<char*>(head), 8);
+    if (in.gcount() != 8) return false;
+    index.interval = static_cast<uint32_t>(getLE(head, 4));
+    uint64_t count = getLE(head + 4, 4);
+    if (index.interval == 0) return false;
+    if (count != (header.originalSize + index.interval - 1) / index.interval) return false;
+
+    std::vector<unsigned char> buf;
+    if (!readIndexEntries(in, count, 12, buf)) return false;
+    index.points.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        index.points[i].bitOffset = getLE(buf.data() + 12 * i, 8);
+        index.points[i].keyIndex = static_cast<uint32_t>(getLE(buf.data() + 12 * i + 8, 4));
+        if (i > 0 && index.points[i].bitOffset < index.points[i - 1].bitOffset) return false;
+    }
+    return true;
+}
+
+// 块校验表：每 unit 字节原始数据一个 CRC32C，最后一个单元可能较短
+struct HfmChecksumIndex {
+    uint32_t unit = 0;
+    std::vector<uint32_t> checksums;
+
+    size_t byteSize() const { return 8 + 4 * checksums.size(); }
+};
+
+inline bool writeChecksumIndex(std::ostream& out, const HfmChecksumIndex& index) {
+    std::vector<unsigned char> buf(index.byteSize());
+    putLE(buf.data(), index.unit, 4);
+    putLE(buf.data() + 4, index.checksums.size(), 4);
+    for (size_t i = 0; i < index.checksums.size(); i++) {
+        putLE(buf.data() + 8 + 4 * i, index.checksums[i], 4);
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return static_cast<bool>(out);
+}
+
+inline bool readChecksumIndex(std::istream& in, const HfmHeader& header, HfmChecksumIndex& index) {
+    unsigned char head[8];
+    in.read(reinterpret_cast<char*>(head), 8);
+    if (in.gcount() != 8) return false;
+    index.unit = static_cast<uint32_t>(getLE(head, 4));
+    uint64_t count = getLE(head + 4, 4);
+    if (index.unit == 0) return false;
+    if (count != (header.originalSize + index.unit - 1) / index.unit) return false;
+
+    std::vector<unsigned char> buf;
+    if (!readIndexEntries(in, count, 4, buf)) return false;
+    index.checksums.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        index.checksums[i] = static_cast<uint32_t>(getLE(buf.data() + 4 * i, 4));
+    }
+    return true;
+}
+
+// 流式读取时跳过头部之后的块索引和同步点索引，只取出块大小（非分块格式为0）。
+// 块校验表较小且解码时要用，给出 checksums 时读入，否则同样跳过。
+// 索引内容不读入内存，输入流可以是管道
+inline bool skipHfmIndexes(std::istream& in, const HfmHeader& header, uint32_t& blockSize,
+                           HfmChecksumIndex* checksums = nullptr) {
+    blockSize = 0;
+    for (uint16_t flag : {HFM_FLAG_BLOCKS, HFM_FLAG_SYNC_POINTS, HFM_FLAG_BLOCK_CHECKSUMS}) {
+        if (!(header.flags & flag)) continue;
+        if (flag == HFM_FLAG_BLOCK_CHECKSUMS && checksums) {
+            if (!readChecksumIndex(in, header, *checksums)) return false;
+            continue;
+        }
+        unsigned char head[8];
+        in.read(reinterpret_cast<char*>(head), 8);
+        if (in.gcount() != 8) return false;
+        uint32_t unit = static_cast<uint32_t>(getLE(head, 4));
+        uint64_t count = getLE(head + 4, 4);
+        if (unit == 0 || count != (header.originalSize + unit - 1) / unit) return false;
+        std::streamsize entries = static_cast<std::streamsize>(
+            flag == HFM_FLAG_BLOCKS ? 8 * (count + 1) : flag == HFM_FLAG_SYNC_POINTS ? 12 * count : 4 * count);
+        in.ignore(entries);
+        if (in.gcount() != entries) return false;
+        if (flag == HFM_FLAG_BLOCKS) blockSize = unit;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef HUFFMAN_MODEL_H
+#define HUFFMAN_MODEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 字节直方图：4 张32位计数表交错累加，相邻的相同字节落在不同的计数器上，
+// 不会互相等待；每处理至多 2^30 字节并入64位总数，总数不会溢出
+inline void countBytes(const unsigned char* data, size_t length, uint64_t counts[256]) {
+    const size_t CHUNK = size_t(1) << 30;
+    uint32_t tables[4][256];
+    while (length > 0) {
+        size_t n = std::min(length, CHUNK);
+        std::memset(tables, 0, sizeof(tables));
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            tables[0][word & 0xFF]++;
+            tables[1][(word >> 8) & 0xFF]++;
+            tables[2][(word >> 16) & 0xFF]++;
+            tables[3][(word >> 24) & 0xFF]++;
+            tables[0][(word >> 32) & 0xFF]++;
+            tables[1][(word >> 40) & 0xFF]++;
+            tables[2][(word >> 48) & 0xFF]++;
+            tables[3][word >> 56]++;
+        }
+        for (; i < n; i++) tables[i & 3][data[i]]++;
+        for (int b = 0; b < 256; b++) {
+            counts[b] += uint64_t(tables[0][b]) + tables[1][b] + tables[2][b] + tables[3][b];
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+// 按码长计算加权路径长度（压缩后的总位数）
+inline uint64_t codeLengthWpl(const uint64_t* counts, const uint8_t* lengths, size_t n = 256) {
+    uint64_t wpl = 0;
+    for (size_t s = 0; s < n; s++) wpl += counts[s] * lengths[s];
+    return wpl;
+}
+
+// 任意大小字母表的哈夫曼码长：符号按（计数, 编号）排序后用两个队列合并，O(n log n)。
+// counts 中非零的符号得到至少1位的码长，其余为0，返回最长码长
+inline int huffmanCodeLengths(const uint64_t* counts, size_t n, uint8_t* lengths) {
+    std::memset(lengths, 0, n);
+    std::vector<uint32_t> symbols;
+    for (size_t s = 0; s < n; s++) {
+        if (counts[s]) symbols.push_back(static_cast<uint32_t>(s));
+    }
+    if (symbols.empty()) return 0;
+    if (symbols.size() == 1) {
+        lengths[symbols[0]] = 1;
+        return 1;
+    }
+    std::stable_sort(symbols.begin(), symbols.end(),
+                     [&](uint32_t a, uint32_t b) { return counts[a] < counts[b]; });
+
+    // 节点 0..k-1 为叶子（排序后），其后为合并出的内部节点；parent 记录父节点下标
+    size_t k = symbols.size();
+    std::vector<uint64_t> weight(2 * k - 1);
+    std::vector<uint32_t> parent(2 * k - 1, 0);
+    for (size_t i = 0; i < k; i++) weight[i] = counts[symbols[i]];
+    size_t leafHead = 0;
+    size_t mergedHead = k;
+    size_t next = k;
+    auto takeMin = [&]() -> size_t {
+        if (mergedHead == next || (leafHead < k && weight[leafHead] <= weight[mergedHead])) {
+            return leafHead++;
+        }
+        return mergedHead++;
+    };
+    while (next < 2 * k - 1) {
+        size_t a = takeMin();
+        size_t b = takeMin();
+        weight[next] = weight[a] + weight[b];
+        parent[a] = parent[b] = static_cast<uint32_t>(next);
+        next++;
+    }
+
+    // 父节点下标总大于子节点，从根向下一遍即可求出深度
+    std::vector<uint8_t> depth(2 * k - 1, 0);
+    int longest = 0;
+    for (size_t i = 2 * k - 1; i-- > 0;) {
+        if (i == 2 * k - 2) continue;
+        depth[i] = static_cast<uint8_t>(std::min(depth[parent[i]] + 1, 255));
+        if (i < k) {
+            lengths[symbols[i]] = depth[i];
+            longest = std::max<int>(longest, depth[i]);
+        }
+    }
+    return longest;
+}
+
+// 码长不超过 maxLength 的最优前缀码（package-merge 算法）。counts 中非零的符号得到
+// 1..maxLength 位的码长，其余为0。出现的符号数超过 2^maxLength 时无解，返回 false
+inline bool limitedCodeLengths(const uint64_t* counts, size_t count, int maxLength, uint8_t* lengths) {
+    std::memset(lengths, 0, count);
+    std::vector<uint32_t> symbols;
+    for (size_t s = 0; s < count; s++) {
+        if (counts[s]) symbols.push_back(static_cast<uint32_t>(s));
+    }
+    size_t n = symbols.size();
+    if (n == 0) return true;
+    if (n == 1) {
+        lengths[symbols[0]] = 1;
+        return true;
+    }
+    if (maxLength < 1 || maxLength > 63 || (maxLength < 32 && n > (size_t(1) << maxLength))) return false;
+    std::stable_sort(symbols.begin(), symbols.end(),
+                     [&](uint32_t a, uint32_t b) { return counts[a] < counts[b]; });
+
+    // levels[d] 是码长第 d+1 位上的候选列表，按权重递增。
+    // 叶子项 leaf 为符号编号；打包项 leaf 为 -1，由下一层相邻两项合并而成
+    struct Item {
+        uint64_t weight;
+        int64_t leaf;
+    };
+    std::vector<std::vector<Item>> levels(maxLength);
+    for (uint32_t s : symbols) levels[maxLength - 1].push_back(Item{counts[s], s});
+    for (int level = maxLength - 2; level >= 0; level--) {
+        const std::vector<Item>& deeper = levels[level + 1];
+        std::vector<Item>& list = levels[level];
+        size_t packages = deeper.size() / 2;
+        size_t li = 0;
+        size_t pi = 0;
+        while (li < n || pi < packages) {
+            uint64_t packed = pi < packages ? deeper[2 * pi].weight + deeper[2 * pi + 1].weight : UINT64_MAX;
+            if (li < n && counts[symbols[li]] <= packed) {
+                list.push_back(Item{counts[symbols[li]], symbols[li]});
+                li++;
+            } else {
+                list.push_back(Item{packed, -1});
+                pi++;
+            }
+        }
+    }
+
+    // 取最上层前 2n-2 项；选中的包按顺序覆盖下一层的前若干项，叶子每被选中一次码长加1
+    size_t take = 2 * n - 2;
+    for (int level = 0; level < maxLength && take > 0; level++) {
+        size_t packages = 0;
+        for (size_t i = 0; i < take; i++) {
+            const Item& item = levels[level][i];
+            if (item.leaf >= 0) {
+                lengths[item.leaf]++;
+            } else {
+                packages++;
+            }
+        }
+        take = 2 * packages;
+    }
+    return true;
+}
+
+inline bool limitedCodeLengths(const uint64_t counts[256], int maxLength, uint8_t lengths[256]) {
+    return limitedCodeLengths(counts, 256, maxLength, lengths);
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef HUFFMAN_PARALLEL_H
+#define HUFFMAN_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "huffman_table_decoder.h"
+#include "huffman_container.h"
+
+// 固定大小的线程池，调用线程本身也参与计算
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextIndex{0};
+    size_t active = 0;        // 尚未完成当前任务的工作线程数
+    uint64_t generation = 0;  // 每提交一次任务加1
+    bool stopping = false;
+
+    void runJob(const std::function<void(size_t)>& fn, size_t count) {
+        size_t i;
+        while ((i = nextIndex.fetch_add(1)) < count) {
+            fn(i);
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)>* fn;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                fn = job;
+                count = jobCount;
+            }
+            runJob(*fn, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) done.notify_one();
+            }
+        }
+    }
+
+public:
+    // threads 为0时使用全部CPU核心
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // 对 i ∈ [0, count) 并行调用 fn(i)，全部完成后返回
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (workers.empty() || count <= 1) {
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            nextIndex = 0;
+            active = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runJob(fn, count);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return active == 0; });
+    }
+};
+
+const unsigned MAX_THREAD_COUNT = 1024;
+
+// 解析交互输入的线程数，留空为0（使用全部CPU核心）。不是 0 到 MAX_THREAD_COUNT 之间的整数时
+// 返回 false，threads 置为0
+inline bool parseThreadCount(const std::string& text, unsigned& threads) {
+    threads = 0;
+    if (text.empty()) return true;
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    if (text[0] < '0' || text[0] > '9' || *end != '\0' || value > MAX_THREAD_COUNT) return false;
+    threads = static_cast<unsigned>(value);
+    return true;
+}
+
+// 分块并行解码。in 的位流起点位于 payloadStart；每轮读入若干块的压缩数据，
+// 各线程解码到预分配输出缓冲区中属于自己的区段，再按顺序写出。
+// transform(data, n, offset) 在各线程中按块调用，offset 为该块在原始数据中的位置，
+// 返回 false 表示该块有误（如块校验失败）。written(data, n) 在写出前按数据顺序调用，
+// 用于累计整个文件的校验值。返回成功解码的字节数，遇到损坏的块立即停止。
+// 每轮分配缓冲区之前先确认这一轮的压缩数据都在输入流内、输出不多于压缩位数，
+// 索引有误时按损坏的块处理，不会按其中的数值分配内存
+template <typename Transform, typename Written>
+uint64_t decodeBlocksParallel(std::istream& in, std::streamoff payloadStart, std::ostream& out,
+                              const HuffmanTableDecoder& decoder, const HfmBlockIndex& index,
+                              uint64_t outputSize, ThreadPool& pool, Transform transform, Written written) {
+    const size_t count = index.blockCount();
+    const uint64_t blockSize = index.blockSize;
+    const size_t blocksPerRound = pool.size() * 4;
+    std::vector<unsigned char> compressed;
+    std::vector<unsigned char> output;
+    uint64_t decoded = 0;
+    in.clear();
+    in.seekg(0, std::ios::end);
+    std::streamoff streamEnd = in.tellg();
+    const uint64_t payloadBytes = streamEnd > payloadStart ? static_cast<uint64_t>(streamEnd - payloadStart) : 0;
+
+    for (size_t first = 0; first < count; first += blocksPerRound) {
+        size_t last = std::min(count, first + blocksPerRound);
+        uint64_t byteBegin = index.bitOffsets[first] / 8;
+        uint64_t byteEnd = (index.bitOffsets[last] + 7) / 8;
+        uint64_t outBegin = first * blockSize;
+        uint64_t outEnd = std::min<uint64_t>(outputSize, last * blockSize);
+        if (index.bitOffsets[last] < index.bitOffsets[first] || byteEnd > payloadBytes || outEnd < outBegin ||
+            outEnd - outBegin > index.bitOffsets[last] - index.bitOffsets[first]) {
+            return decoded;
+        }
+        compressed.resize(static_cast<size_t>(byteEnd - byteBegin));
+        in.clear();
+        in.seekg(payloadStart + static_cast<std::streamoff>(byteBegin));
+        in.read(reinterpret_cast<char*>(compressed.data()), compressed.size());
+        if (in.gcount() != static_cast<std::streamsize>(compressed.size())) return decoded;
+
+        output.resize(static_cast<size_t>(outEnd - outBegin));
+        std::vector<char> ok(last - first, 0);
+
+        pool.parallelFor(last - first, [&](size_t k) {
+            size_t b = first + k;
+            uint64_t startBit = index.bitOffsets[b];
+            uint64_t endBit = index.bitOffsets[b + 1];
+            size_t offset = static_cast<size_t>(startBit / 8 - byteBegin);
+            size_t length = static_cast<size_t>((endBit + 7) / 8 - startBit / 8);
+            BitReader reader(compressed.data() + offset, length);
+            reader.skipBits(static_cast<int>(startBit % 8));
+
+            uint64_t blockStart = b * blockSize;
+            size_t want = static_cast<size_t>(std::min<uint64_t>(blockSize, outputSize - blockStart));
+            unsigned char* dst = output.data() + (blockStart - outBegin);
+            if (decoder.decodeSymbols(reader, dst, want) == want && transform(dst, want, blockStart)) {
+                ok[k] = 1;
+            }
+        });
+
+        for (size_t k = 0; k < ok.size(); k++) {
+            if (!ok[k]) {
+                size_t good = static_cast<size_t>(std::min<uint64_t>((first + k) * blockSize, outEnd) - outBegin);
+                written(output.data(), good);
+                out.write(reinterpret_cast<const char*>(output.data()), good);
+                return decoded + good;
+            }
+        }
+        written(output.data(), output.size());
+        out.write(reinterpret_cast<const char*>(output.data()), output.size());
+        decoded += output.size();
+    }
+    return decoded;
+}
+
+template <typename Transform>
+uint64_t decodeBlocksParallel(std::istream& in, std::streamoff payloadStart, std::ostream& out,
+                              const HuffmanTableDecoder& decoder, const HfmBlockIndex& index,
+                              uint64_t outputSize, ThreadPool& pool, Transform transform) {
+    return decodeBlocksParallel(in, payloadStart, out, decoder, index, outputSize, pool, transform,
+                                [](const unsigned char*, size_t) {});
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef HUFFMAN_STREAM_H
+#define HUFFMAN_STREAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "huffman_bits.h"
+#include "huffman_container.h"
+#include "huffman_table_decoder.h"
+
+// 推/拉式流接口：数据用 feed 分段推入，结果用 read 分段取出。内部只有固定容量的缓冲区，
+// feed 在缓冲区将满时只接受一部分，调用方取走输出后再继续推入，
+// 因此输入可以来自管道或套接字，内存占用与数据总量无关
+
+// 流式编码器：编码表由规范码长给出（来自第一遍统计或已有容器的头部），输出不含容器头部的位流
+class HuffmanStreamEncoder {
+private:
+    HuffmanBitEncoder encoder;
+    bool hasCode[256] = {};
+    bool complete = true;   // 256 个字节值是否都有编码
+    int maxLength = 0;
+    size_t capacity;
+    std::vector<unsigned char> pending;  // 已编码、等待 read 取出的字节
+    size_t readPos = 0;
+    BitWriter writer;
+    uint64_t inputBytes = 0;
+    bool finished = false;
+    bool failed = false;
+
+    size_t buffered() const { return pending.size() - readPos; }
+
+public:
+    explicit HuffmanStreamEncoder(const uint8_t lengths[256], size_t bufferSize = 1 << 16)
+        : capacity(std::max<size_t>(bufferSize, 64)), writer(pending, 4096) {
+        CodeWord codes[256];
+        if (!canonicalCodes(lengths, codes)) {
+            failed = true;
+            return;
+        }
+        for (int b = 0; b < 256; b++) {
+            encoder.setCode(static_cast<unsigned char>(b), codes[b]);
+            hasCode[b] = codes[b].length != 0;
+            complete = complete && hasCode[b];
+            maxLength = std::max<int>(maxLength, codes[b].length);
+        }
+        pending.reserve(capacity + 4096);
+    }
+
+    // 推入一段原始数据，返回实际接受的字节数。
+    // 遇到编码表中没有的字节时停在该字节之前并进入错误状态
+    size_t feed(const unsigned char* data, size_t length) {
+        if (finished || failed) return 0;
+        size_t room = capacity > buffered() ? capacity - buffered() : 0;
+        size_t accept = maxLength ? std::min(length, room * 8 / maxLength) : 0;
+        if (!complete) {
+            for (size_t i = 0; i < accept; i++) {
+                if (!hasCode[data[i]]) {
+                    accept = i;
+                    failed = true;
+                    break;
+                }
+            }
+            if (maxLength == 0 && length > 0) failed = true;
+        }
+        encoder.encode(data, accept, writer);
+        writer.flush();
+        inputBytes += accept;
+        return accept;
+    }
+
+    // 输入结束：写出最后不足一个字节的位
+    void finish() {
+        if (finished) return;
+        writer.finish();
+        finished = true;
+    }
+
+    // 取出最多 n 个已编码字节，返回实际取出数
+    size_t read(unsigned char* dst, size_t n) {
+        n = std::min(n, buffered());
+        std::memcpy(dst, pending.data() + readPos, n);
+        readPos += n;
+        if (readPos == pending.size()) {
+            pending.clear();
+            readPos = 0;
+        } else if (readPos >= capacity / 2) {
+            pending.erase(pending.begin(), pending.begin() + readPos);
+            readPos = 0;
+        }
+        return n;
+    }
+
+    bool ok() const { return !failed; }
+    // finish 之后且输出已全部取出
+    bool done() const { return finished && buffered() == 0; }
+    uint64_t bytesIn() const { return inputBytes; }
+    uint64_t bytesOut() const { return writer.bytesWritten(); }
+    // 输出位流校验值的算法，须在 feed 之前设置
+    void setOutputChecksum(uint8_t algorithm) { writer.setChecksum(algorithm); }
+    uint64_t outputChecksum() const { return writer.outputChecksum(); }
+};
+
+// 流式解码器：推入位流，拉出原始数据，共解码 outputSize 个字节。
+// 分块格式的位流每块从字节边界开始，给出 blockSize 后在块边界自动跳过填充位
+class HuffmanStreamDecoder {
+private:
+    HuffmanTableDecoder decoder;
+    bool valid;
+    size_t capacity;
+    std::vector<unsigned char> pending;  // 尚未解码的输入
+    int bitOffset = 0;                   // pending[0] 中已消耗的位数
+    uint64_t outputSize;
+    uint64_t blockSize;
+    uint64_t produced = 0;
+    bool inputEnded = false;
+
+public:
+    HuffmanStreamDecoder(const uint8_t lengths[256], uint64_t size, uint64_t block = 0,
+                         size_t bufferSize = 1 << 16)
+        : capacity(std::max<size_t>(bufferSize, 64)), outputSize(size), blockSize(block) {
+        valid = decoder.build(codeListFromLengths(lengths));
+        pending.reserve(capacity);
+    }
+
+    // 推入一段位流，返回实际接受的字节数
+    size_t feed(const unsigned char* data, size_t length) {
+        size_t accept = std::min(length, capacity - pending.size());
+        pending.insert(pending.end(), data, data + accept);
+        return accept;
+    }
+
+    void finish() { inputEnded = true; }
+
+    // 解码出最多 n 个字节，返回实际数目。返回0且 done() 为假时，
+    // 说明需要继续 feed；输入已结束时则表示位流被截断或已损坏
+    size_t read(unsigned char* dst, size_t n) {
+        if (!valid) return 0;
+        uint64_t limit = outputSize - produced;
+        if (blockSize) limit = std::min(limit, blockSize - produced % blockSize);
+        size_t want = static_cast<size_t>(std::min<uint64_t>(n, limit));
+        if (want == 0) return 0;
+
+        BitReader reader(pending.data(), pending.size());
+        if (bitOffset) reader.skipBits(bitOffset);
+        size_t got = decoder.decodeSymbols(reader, dst, want);
+        uint64_t consumedBits = pending.size() * 8 - reader.remainingBits();
+        produced += got;
+        // 块结束后下一块从新的字节开始
+        if (blockSize && produced % blockSize == 0 && consumedBits % 8) {
+            consumedBits += 8 - consumedBits % 8;
+        }
+        pending.erase(pending.begin(), pending.begin() + static_cast<size_t>(consumedBits / 8));
+        bitOffset = static_cast<int>(consumedBits % 8);
+        return got;
+    }
+
+    bool ok() const { return valid; }
+    bool done() const { return produced == outputSize; }
+    // 输入已结束但数据没有解码完整
+    bool truncated() const { return inputEnded && !done(); }
+    uint64_t bytesOut() const { return produced; }
+};
+
+#endif
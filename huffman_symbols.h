@@ -0,0 +1,407 @@
+#ifndef HUFFMAN_SYMBOLS_H
+#define HUFFMAN_SYMBOLS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "huffman_bits.h"
+#include "huffman_container.h"
+#include "huffman_model.h"
+#include "huffman_table_decoder.h"
+
+// 多字节符号模式：字母表除256个单字节符号外，还包括文本中常见的整个 UTF-8 或 GBK 字符，
+// 一个汉字只需一次查表编码、一次查表解码。不合法或不完整的序列、以及出现次数太少
+// 不值得进入符号表的字符，都退回按单字节编码，因此任意数据都可以压缩。
+// 符号编号：0-255 为单字节，256 起为多字节符号（按键升序）。
+// 多字节字符的键：UTF-8 为码点，GBK 为两个字节组成的16位值
+enum class SymbolAlphabet : uint8_t {
+    BYTES = 0,
+    UTF8 = 1,
+    GBK = 2
+};
+
+inline const char* alphabetName(SymbolAlphabet alphabet) {
+    switch (alphabet) {
+        case SymbolAlphabet::UTF8: return "UTF-8";
+        case SymbolAlphabet::GBK: return "GBK";
+        default: return "单字节";
+    }
+}
+
+// 键的取值范围
+inline uint32_t keySpace(SymbolAlphabet alphabet) {
+    return alphabet == SymbolAlphabet::UTF8 ? 0x110000 : 0x10000;
+}
+
+// p 开头的符号长度：合法的多字节字符返回其字节数，否则返回1（按单字节处理）。
+// 已有字节是合法前缀、但 available 不够一个完整字符时返回0，由调用方等待更多数据
+inline int symbolLength(SymbolAlphabet alphabet, const unsigned char* p, size_t available) {
+    unsigned char b0 = p[0];
+    if (alphabet == SymbolAlphabet::GBK) {
+        if (b0 < 0x81 || b0 == 0xFF) return 1;
+        if (available < 2) return 0;
+        unsigned char b1 = p[1];
+        return b1 >= 0x40 && b1 <= 0xFE && b1 != 0x7F ? 2 : 1;
+    }
+    if (alphabet != SymbolAlphabet::UTF8 || b0 < 0xC2 || b0 > 0xF4) return 1;
+    int need = b0 < 0xE0 ? 2 : b0 < 0xF0 ? 3 : 4;
+    // 第二个字节的范围排除超长编码、代理区和超出 U+10FFFF 的码点
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (b0 == 0xE0) low = 0xA0;
+    else if (b0 == 0xED) high = 0x9F;
+    else if (b0 == 0xF0) low = 0x90;
+    else if (b0 == 0xF4) high = 0x8F;
+    for (int i = 1; i < need; i++) {
+        if (static_cast<size_t>(i) >= available) return 0;
+        unsigned char b = p[i];
+        if (i == 1 ? (b < low || b > high) : (b & 0xC0) != 0x80) return 1;
+    }
+    return need;
+}
+
+inline uint32_t symbolKey(SymbolAlphabet alphabet, const unsigned char* p, int length) {
+    if (alphabet == SymbolAlphabet::GBK) return (uint32_t(p[0]) << 8) | p[1];
+    uint32_t key = p[0] & (0x7F >> length);
+    for (int i = 1; i < length; i++) key = (key << 6) | (p[i] & 0x3F);
+    return key;
+}
+
+// 键还原为字节序列，返回字节数；键不对应合法的多字节字符时返回0
+inline int keyToBytes(SymbolAlphabet alphabet, uint32_t key, unsigned char out[4]) {
+    if (alphabet == SymbolAlphabet::GBK) {
+        if (key > 0xFFFF) return 0;
+        out[0] = static_cast<unsigned char>(key >> 8);
+        out[1] = static_cast<unsigned char>(key);
+        return symbolLength(alphabet, out, 2) == 2 ? 2 : 0;
+    }
+    if (alphabet != SymbolAlphabet::UTF8 || key < 0x80 || key > 0x10FFFF) return 0;
+    if (key >= 0xD800 && key <= 0xDFFF) return 0;
+    int length = key < 0x800 ? 2 : key < 0x10000 ? 3 : 4;
+    for (int i = length - 1; i > 0; i--) {
+        out[i] = static_cast<unsigned char>(0x80 | (key & 0x3F));
+        key >>= 6;
+    }
+    out[0] = static_cast<unsigned char>((0xF00 >> length) | key);
+    return length;
+}
+
+// 把连续的数据切分为符号。数据可以分段送入，末尾不完整的多字节字符暂存到下一段；
+// flush 表示此处是符号边界，暂存的字节按单字节输出
+class SymbolTokenizer {
+private:
+    SymbolAlphabet alphabet;
+    unsigned char carry[3];
+    size_t carryLength = 0;
+
+public:
+    explicit SymbolTokenizer(SymbolAlphabet a = SymbolAlphabet::BYTES) : alphabet(a) {}
+
+    // 对每个符号调用 visit(const unsigned char* p, int length)
+    template <typename Visit>
+    void feed(const unsigned char* data, size_t length, Visit visit) {
+        size_t i = 0;
+        if (carryLength > 0) {
+            // 暂存的字节与新数据开头拼接后切分，直到越过暂存部分
+            unsigned char joined[8];
+            std::memcpy(joined, carry, carryLength);
+            size_t take = std::min(length, sizeof(joined) - carryLength);
+            std::memcpy(joined + carryLength, data, take);
+            size_t total = carryLength + take;
+            size_t p = 0;
+            while (p < carryLength) {
+                int n = symbolLength(alphabet, joined + p, total - p);
+                if (n == 0) {
+                    // 新数据已全部拼入，仍不完整
+                    carryLength = total - p;
+                    std::memmove(carry, joined + p, carryLength);
+                    return;
+                }
+                visit(joined + p, n);
+                p += n;
+            }
+            i = p - carryLength;
+            carryLength = 0;
+        }
+        while (i < length) {
+            if (data[i] < 0x80) {
+                visit(data + i, 1);
+                i++;
+                continue;
+            }
+            int n = symbolLength(alphabet, data + i, length - i);
+            if (n == 0) {
+                carryLength = length - i;
+                std::memcpy(carry, data + i, carryLength);
+                return;
+            }
+            visit(data + i, n);
+            i += n;
+        }
+    }
+
+    template <typename Visit>
+    void flush(Visit visit) {
+        for (size_t i = 0; i < carryLength; i++) visit(carry + i, 1);
+        carryLength = 0;
+    }
+};
+
+// 统计单字节符号和各多字节字符的出现次数
+class SymbolCounter {
+private:
+    SymbolTokenizer tokenizer;
+    std::vector<uint64_t> keys;  // 按键下标的出现次数
+
+public:
+    SymbolAlphabet alphabet;
+    uint64_t byteCounts[256] = {};  // 作为单字节符号出现的次数
+    uint64_t totalBytes = 0;
+
+    explicit SymbolCounter(SymbolAlphabet a)
+        : tokenizer(a), keys(keySpace(a), 0), alphabet(a) {}
+
+    void add(const unsigned char* data, size_t length) {
+        totalBytes += length;
+        tokenizer.feed(data, length, [&](const unsigned char* p, int n) {
+            if (n == 1) {
+                byteCounts[*p]++;
+            } else {
+                keys[symbolKey(alphabet, p, n)]++;
+            }
+        });
+    }
+
+    // 符号边界：多字节字符不跨越此处
+    void flush() {
+        tokenizer.flush([&](const unsigned char* p, int) { byteCounts[*p]++; });
+    }
+
+    uint64_t keyCount(uint32_t key) const { return keys[key]; }
+};
+
+// 多字节符号表，写在容器中其他索引之后：
+//   1     字符集（1 UTF-8，2 GBK）
+//   4     多字节符号数 m
+//   m 项  键与上一项的差（变长整数，每字节7位、低位在前，最高位表示后面还有字节）+ 1 字节码长
+// 第一项的差即键本身，键严格递增
+struct HfmSymbolTable {
+    SymbolAlphabet alphabet = SymbolAlphabet::BYTES;
+    std::vector<uint32_t> keys;
+    std::vector<uint8_t> lengths;  // 与 keys 一一对应
+
+    size_t byteSize() const {
+        size_t size = 5;
+        uint32_t previous = 0;
+        for (uint32_t key : keys) {
+            for (uint32_t delta = key - previous; ; delta >>= 7) {
+                size++;
+                if (delta < 0x80) break;
+            }
+            size++;
+            previous = key;
+        }
+        return size;
+    }
+};
+
+inline bool writeSymbolTable(std::ostream& out, const HfmSymbolTable& table) {
+    std::vector<unsigned char> buf(5);
+    buf[0] = static_cast<unsigned char>(table.alphabet);
+    putLE(buf.data() + 1, table.keys.size(), 4);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < table.keys.size(); i++) {
+        uint32_t delta = table.keys[i] - previous;
+        while (delta >= 0x80) {
+            buf.push_back(static_cast<unsigned char>(0x80 | (delta & 0x7F)));
+            delta >>= 7;
+        }
+        buf.push_back(static_cast<unsigned char>(delta));
+        buf.push_back(table.lengths[i]);
+        previous = table.keys[i];
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return static_cast<bool>(out);
+}
+
+// 读取符号表并检查：键合法且递增，与头部的单字节码长合起来是有效的前缀码
+inline bool readSymbolTable(std::istream& in, const HfmHeader& header, HfmSymbolTable& table) {
+    unsigned char head[5];
+    in.read(reinterpret_cast<char*>(head), 5);
+    if (in.gcount() != 5) return false;
+    table.alphabet = static_cast<SymbolAlphabet>(head[0]);
+    if (table.alphabet != SymbolAlphabet::UTF8 && table.alphabet != SymbolAlphabet::GBK) return false;
+    uint64_t count = getLE(head + 1, 4);
+    if (count > keySpace(table.alphabet)) return false;
+    table.keys.clear();
+    table.lengths.clear();
+    uint64_t previous = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t delta = 0;
+        int c;
+        for (int shift = 0; ; shift += 7) {
+            if (shift > 21 || (c = in.get()) == EOF) return false;
+            delta |= static_cast<uint64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80)) break;
+        }
+        if ((c = in.get()) == EOF) return false;
+        uint64_t key = previous + delta;
+        unsigned char bytes[4];
+        if ((i > 0 && delta == 0) || key >= keySpace(table.alphabet) ||
+            keyToBytes(table.alphabet, static_cast<uint32_t>(key), bytes) == 0) {
+            return false;
+        }
+        table.keys.push_back(static_cast<uint32_t>(key));
+        table.lengths.push_back(static_cast<uint8_t>(c));
+        previous = key;
+    }
+    std::vector<uint8_t> lengths(header.codeLengths, header.codeLengths + 256);
+    lengths.insert(lengths.end(), table.lengths.begin(), table.lengths.end());
+    std::vector<CodeWord> codes(lengths.size());
+    return canonicalCodes(lengths.data(), lengths.size(), codes.data());
+}
+
+// 由统计结果选出多字节符号并求出全部码长，单字节码长写入 byteLengths，
+// counts 返回按符号编号排列的出现次数。
+// 某个字符作为独立符号节省的位数（按熵估算）超过它在符号表中约3个字节的开销时才入选；
+// 码长超过 maxLength 时改用受限码长，符号数超过 2^maxLength 时先舍弃出现次数少的字符
+inline void buildSymbolModel(const SymbolCounter& counter, int maxLength, HfmSymbolTable& table,
+                             uint8_t byteLengths[256], std::vector<uint64_t>& counts) {
+    const double ENTRY_BITS = 24.0;
+    table.alphabet = counter.alphabet;
+    table.keys.clear();
+    table.lengths.clear();
+
+    // 单字节模式下各字节值的出现次数及其编码位数的估计
+    uint64_t raw[256];
+    std::memcpy(raw, counter.byteCounts, sizeof(raw));
+    uint64_t tokens = counter.totalBytes;
+    unsigned char bytes[4];
+    std::vector<uint32_t> candidates;
+    for (uint32_t key = 0; key < keySpace(counter.alphabet); key++) {
+        uint64_t c = counter.keyCount(key);
+        if (!c) continue;
+        int n = keyToBytes(counter.alphabet, key, bytes);
+        for (int i = 0; i < n; i++) raw[bytes[i]] += c;
+        tokens -= c * (n - 1);
+        candidates.push_back(key);
+    }
+    double total = static_cast<double>(counter.totalBytes);
+
+    std::vector<std::pair<uint64_t, uint32_t>> chosen;  // (出现次数, 键)
+    for (uint32_t key : candidates) {
+        uint64_t c = counter.keyCount(key);
+        int n = keyToBytes(counter.alphabet, key, bytes);
+        double byteBits = 0;
+        for (int i = 0; i < n; i++) byteBits += std::log2(total / raw[bytes[i]]);
+        double symbolBits = std::log2(static_cast<double>(tokens) / c);
+        if (c * (byteBits - symbolBits) > ENTRY_BITS) chosen.emplace_back(c, key);
+    }
+    if (maxLength < 32) {
+        size_t usedBytes = static_cast<size_t>(std::count_if(raw, raw + 256, [](uint64_t c) { return c != 0; }));
+        size_t room = (size_t(1) << maxLength) > usedBytes ? (size_t(1) << maxLength) - usedBytes : 0;
+        if (chosen.size() > room) {
+            std::stable_sort(chosen.begin(), chosen.end(),
+                             [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+                                 return a.first > b.first;
+                             });
+            chosen.resize(room);
+        }
+    }
+    for (const auto& pair : chosen) table.keys.push_back(pair.second);
+    std::sort(table.keys.begin(), table.keys.end());
+
+    // 未入选的字符按单字节计数
+    counts.assign(256 + table.keys.size(), 0);
+    std::copy(counter.byteCounts, counter.byteCounts + 256, counts.begin());
+    size_t next = 0;
+    for (uint32_t key : candidates) {
+        uint64_t c = counter.keyCount(key);
+        if (next < table.keys.size() && table.keys[next] == key) {
+            counts[256 + next++] = c;
+            continue;
+        }
+        int n = keyToBytes(counter.alphabet, key, bytes);
+        for (int i = 0; i < n; i++) counts[bytes[i]] += c;
+    }
+
+    std::vector<uint8_t> lengths(counts.size());
+    if (huffmanCodeLengths(counts.data(), counts.size(), lengths.data()) > maxLength) {
+        limitedCodeLengths(counts.data(), counts.size(), maxLength, lengths.data());
+    }
+    std::memcpy(byteLengths, lengths.data(), 256);
+    table.lengths.assign(lengths.begin() + 256, lengths.end());
+}
+
+// 多字节符号编码器：单字节符号查 256 项表，多字节字符按键查表，
+// 不在符号表中的字符逐字节编码
+class HuffmanSymbolEncoder {
+private:
+    SymbolAlphabet alphabet = SymbolAlphabet::BYTES;
+    SymbolTokenizer tokenizer;
+    CodeWord byteCodes[256];
+    std::vector<CodeWord> keyCodes;  // 按键下标，长度为0表示不是独立符号
+
+    void put(BitWriter& writer, const unsigned char* p, int n) const {
+        if (n > 1) {
+            uint32_t key = symbolKey(alphabet, p, n);
+            if (key < keyCodes.size() && keyCodes[key].length) {
+                writer.put(keyCodes[key].bits, keyCodes[key].length);
+                return;
+            }
+        }
+        for (int i = 0; i < n; i++) writer.put(byteCodes[p[i]].bits, byteCodes[p[i]].length);
+    }
+
+public:
+    // 按规范编码建立编码表，码长无效时返回 false
+    bool build(const uint8_t byteLengths[256], const HfmSymbolTable& table) {
+        alphabet = table.alphabet;
+        tokenizer = SymbolTokenizer(alphabet);
+        std::vector<uint8_t> lengths(byteLengths, byteLengths + 256);
+        lengths.insert(lengths.end(), table.lengths.begin(), table.lengths.end());
+        std::vector<CodeWord> codes(lengths.size());
+        if (!canonicalCodes(lengths.data(), lengths.size(), codes.data())) return false;
+        std::copy(codes.begin(), codes.begin() + 256, byteCodes);
+        keyCodes.assign(table.keys.empty() ? 0 : table.keys.back() + 1, CodeWord());
+        for (size_t i = 0; i < table.keys.size(); i++) keyCodes[table.keys[i]] = codes[256 + i];
+        return true;
+    }
+
+    void encode(const unsigned char* data, size_t length, BitWriter& writer) {
+        tokenizer.feed(data, length, [&](const unsigned char* p, int n) { put(writer, p, n); });
+    }
+
+    // 符号边界：写出暂存的不完整字符
+    void flush(BitWriter& writer) {
+        tokenizer.flush([&](const unsigned char* p, int n) { put(writer, p, n); });
+    }
+};
+
+// 由头部的单字节码长和符号表建立解码器
+inline bool buildSymbolDecoder(HuffmanTableDecoder& decoder, const HfmHeader& header,
+                               const HfmSymbolTable& table) {
+    std::vector<uint8_t> lengths(header.codeLengths, header.codeLengths + 256);
+    lengths.insert(lengths.end(), table.lengths.begin(), table.lengths.end());
+    std::vector<CodeWord> codes(lengths.size());
+    if (!canonicalCodes(lengths.data(), lengths.size(), codes.data())) return false;
+    std::vector<std::pair<std::string, CodeWord>> list;
+    for (size_t s = 0; s < lengths.size(); s++) {
+        if (!codes[s].length) continue;
+        if (s < 256) {
+            list.emplace_back(std::string(1, static_cast<char>(s)), codes[s]);
+            continue;
+        }
+        unsigned char bytes[4];
+        int n = keyToBytes(table.alphabet, table.keys[s - 256], bytes);
+        list.emplace_back(std::string(reinterpret_cast<const char*>(bytes), n), codes[s]);
+    }
+    return decoder.build(list);
+}
+
+#endif
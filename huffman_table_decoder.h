@@ -0,0 +1,285 @@
+#ifndef HUFFMAN_TABLE_DECODER_H
+#define HUFFMAN_TABLE_DECODER_H
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "huffman_bits.h"
+
+// 表驱动哈夫曼解码器：一级表按前 PRIMARY_BITS 位直接查出符号，
+// 更长的编码经链接项进入溢出子表继续查找。
+// 符号可以是单个字节，也可以是最多 MAX_SYMBOL_BYTES 个字节的序列（多字节字符），
+// 后者每解码一个符号输出多个字节
+class HuffmanTableDecoder {
+public:
+    static const int PRIMARY_BITS = 11;     // 一级表索引位数
+    static const int MULTI_BYTE_PRIMARY_BITS = 12;  // 有多字节符号时字母表更大，一级表加宽一位
+    static const int SUB_BITS = 8;          // 溢出子表最大索引位数
+    static const int MAX_SYMBOL_BYTES = 4;  // 单个符号最多输出的字节数
+
+private:
+    enum EntryKind : uint8_t { INVALID = 0, LEAF = 1, LINK = 2 };
+
+    struct Entry {
+        uint32_t value;  // LEAF: 符号的字节，按内存顺序存放；LINK: 子表起始下标
+        uint8_t length;  // LEAF: 本表内消耗的位数；LINK: 子表索引位数
+        uint8_t kind;
+        uint8_t bytes;   // LEAF: 符号的字节数
+    };
+
+    struct Symbol {
+        uint32_t value;
+        uint8_t bytes;
+        CodeWord code;
+    };
+
+    std::vector<Entry> tables;  // 所有表连续存放，一级表位于开头
+    int primaryBits = 0;
+    bool multiByte = false;     // 是否有多字节符号
+    bool singleSymbol = false;  // 只有一个符号且编码长度为0
+    Symbol onlySymbol{};
+
+    // 取编码中从第 consumed 位开始的 width 位，不足部分补0
+    static uint32_t indexOf(const CodeWord& code, int consumed, int width) {
+        int remaining = code.length - consumed;
+        uint64_t tail = remaining >= 64 ? code.bits : (code.bits & ((uint64_t(1) << remaining) - 1));
+        if (remaining >= width) {
+            return static_cast<uint32_t>(tail >> (remaining - width));
+        }
+        return static_cast<uint32_t>(tail << (width - remaining));
+    }
+
+    // 为共享前 consumed 位的一组编码建立宽度为 width 的表，返回表起始下标，失败返回 -1
+    long buildTable(const std::vector<Symbol>& group, int consumed, int width) {
+        size_t base = tables.size();
+        tables.resize(base + (size_t(1) << width), Entry{0, 0, INVALID, 0});
+
+        std::vector<std::vector<Symbol>> children(size_t(1) << width);
+        for (const Symbol& s : group) {
+            int remaining = s.code.length - consumed;
+            uint32_t index = indexOf(s.code, consumed, width);
+            if (remaining <= width) {
+                // 短编码：填充所有以该编码为前缀的表项
+                uint32_t span = uint32_t(1) << (width - remaining);
+                for (uint32_t i = 0; i < span; i++) {
+                    Entry& e = tables[base + index + i];
+                    if (e.kind != INVALID) return -1;  // 不是前缀码
+                    e = Entry{s.value, static_cast<uint8_t>(remaining), LEAF, s.bytes};
+                }
+            } else {
+                if (tables[base + index].kind == LEAF) return -1;
+                tables[base + index].kind = LINK;
+                children[index].push_back(s);
+            }
+        }
+
+        for (uint32_t index = 0; index < children.size(); index++) {
+            if (children[index].empty()) continue;
+            int maxRemaining = 0;
+            for (const Symbol& s : children[index]) {
+                maxRemaining = std::max(maxRemaining, s.code.length - consumed - width);
+            }
+            int childWidth = std::min(maxRemaining, SUB_BITS);
+            long child = buildTable(children[index], consumed + width, childWidth);
+            if (child < 0) return -1;
+            tables[base + index] = Entry{static_cast<uint32_t>(child),
+                                         static_cast<uint8_t>(childWidth), LINK, 0};
+        }
+        return static_cast<long>(base);
+    }
+
+    // 由符号列表建立查找表。编码按规范顺序（长度、码值）排列后填表，
+    // 因此对树形编码和规范哈夫曼编码都适用
+    bool buildFrom(std::vector<Symbol> symbols) {
+        tables.clear();
+        singleSymbol = false;
+        multiByte = false;
+        primaryBits = 0;
+
+        // 长度为0的项只在唯一符号时有意义
+        if (symbols.size() == 1 && symbols.front().code.length == 0) {
+            singleSymbol = true;
+            onlySymbol = symbols.front();
+            multiByte = onlySymbol.bytes > 1;
+            return true;
+        }
+        symbols.erase(std::remove_if(symbols.begin(), symbols.end(),
+                                     [](const Symbol& s) { return s.code.length == 0; }),
+                      symbols.end());
+        if (symbols.empty()) return false;
+        for (const Symbol& s : symbols) multiByte = multiByte || s.bytes > 1;
+        std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
+            if (a.code.length != b.code.length) return a.code.length < b.code.length;
+            return a.code.bits < b.code.bits;
+        });
+
+        int maxLength = symbols.back().code.length;
+        primaryBits = std::min(maxLength, multiByte ? MULTI_BYTE_PRIMARY_BITS : PRIMARY_BITS);
+        if (buildTable(symbols, 0, primaryBits) < 0) {
+            tables.clear();
+            return false;
+        }
+        return true;
+    }
+
+public:
+    // 由 (字节, 编码) 列表建立查找表
+    bool build(const std::vector<std::pair<unsigned char, CodeWord>>& codes) {
+        std::vector<Symbol> symbols;
+        for (const auto& pair : codes) symbols.push_back(Symbol{pair.first, 1, pair.second});
+        return buildFrom(symbols);
+    }
+
+    // 由 (字节序列, 编码) 列表建立查找表，每个序列 1..MAX_SYMBOL_BYTES 个字节
+    bool build(const std::vector<std::pair<std::string, CodeWord>>& codes) {
+        std::vector<Symbol> symbols;
+        for (const auto& pair : codes) {
+            if (pair.first.empty() || pair.first.size() > MAX_SYMBOL_BYTES) return false;
+            Symbol s{0, static_cast<uint8_t>(pair.first.size()), pair.second};
+            std::memcpy(&s.value, pair.first.data(), pair.first.size());
+            symbols.push_back(s);
+        }
+        return buildFrom(symbols);
+    }
+
+    bool hasMultiByteSymbols() const { return multiByte; }
+
+    // 解码最多 count 个单字节符号到 out，返回实际解码数。输入提前结束或遇到无效编码时提前返回。
+    // 只用于没有多字节符号的编码表
+    size_t decodeSymbols(BitReader& reader, unsigned char* out, size_t count) const {
+        if (singleSymbol) {
+            std::memset(out, static_cast<unsigned char>(onlySymbol.value), count);
+            return count;
+        }
+        return decodeLoop<false>(reader, out, count);
+    }
+
+    // 解码到 out 中至少 count 个字节为止，返回实际字节数。有多字节符号时最后一个符号可能
+    // 越过 count，最多多出 MAX_SYMBOL_BYTES-1 个字节，out 须留出这部分空间。
+    // 输入提前结束或遇到无效编码时提前返回
+    size_t decodeBytes(BitReader& reader, unsigned char* out, size_t count) const {
+        if (!multiByte) return decodeSymbols(reader, out, count);
+        size_t produced = 0;
+        if (singleSymbol) {
+            while (produced < count) {
+                std::memcpy(out + produced, &onlySymbol.value, MAX_SYMBOL_BYTES);
+                produced += onlySymbol.bytes;
+            }
+            return produced;
+        }
+        return decodeLoop<true>(reader, out, count);
+    }
+
+private:
+    // 写出一个叶子符号，返回字节数。多字节模式整字写入4个字节，再按实际长度前进
+    template <bool MultiByte>
+    static size_t emit(const Entry& e, unsigned char* out) {
+        if (MultiByte) {
+            std::memcpy(out, &e.value, MAX_SYMBOL_BYTES);
+            return e.bytes;
+        }
+        *out = static_cast<unsigned char>(e.value);
+        return 1;
+    }
+
+    template <bool MultiByte>
+    size_t decodeLoop(BitReader& reader, unsigned char* out, size_t count) const {
+        const Entry* primary = tables.data();
+        size_t produced = 0;
+        while (produced < count) {
+            reader.refill();
+            // 快速路径：一次补充后连续解码所有命中一级表的符号
+            while (produced < count && reader.bitCount >= primaryBits) {
+                const Entry& e = primary[reader.peek(primaryBits)];
+                if (e.kind != LEAF) break;
+                reader.consume(e.length);
+                produced += emit<MultiByte>(e, out + produced);
+            }
+            if (produced >= count) break;
+
+            // 慢速路径：长编码逐级查子表，或处理输入末尾。先在位缓冲区副本上查出完整编码，
+            // 位数不够时不消耗任何输入，分段推入数据的调用方可以补充输入后重试
+            reader.refill();
+            uint64_t bits = reader.bitBuf;
+            int used = 0;
+            int width = primaryBits;
+            const Entry* table = primary;
+            bool decoded = false;
+            while (true) {
+                const Entry& e = table[static_cast<uint32_t>(bits >> (64 - width))];
+                if (e.kind == LEAF) {
+                    if (used + e.length > reader.bitCount) break;
+                    reader.consume(used + e.length);
+                    produced += emit<MultiByte>(e, out + produced);
+                    decoded = true;
+                    break;
+                }
+                if (e.kind != LINK || used + width > reader.bitCount) break;
+                bits <<= width;
+                used += width;
+                table = tables.data() + e.value;
+                width = e.length;
+            }
+            if (decoded) continue;
+            // 缓冲区已满（超过56位）仍查不完的超长编码，逐级消耗并补充输入
+            if (reader.bitCount <= 56) return produced;
+            width = primaryBits;
+            table = primary;
+            while (true) {
+                if (reader.bitCount < width) reader.refill();
+                const Entry& e = table[reader.peek(width)];
+                if (e.kind == LEAF) {
+                    if (e.length > reader.bitCount) return produced;  // 输入被截断
+                    reader.consume(e.length);
+                    produced += emit<MultiByte>(e, out + produced);
+                    break;
+                }
+                if (e.kind != LINK || reader.bitCount < width) return produced;
+                reader.consume(width);
+                table = tables.data() + e.value;
+                width = e.length;
+            }
+        }
+        return produced;
+    }
+
+public:
+    // 从输入流解码 outputSize 个字节写入输出流。transform 在写出前对每块数据调用一次，
+    // 形如 bool(unsigned char* data, size_t n)，用于解密、校验等逐字节处理；
+    // 返回 false 时这块数据不写出并立即停止解码
+    template <typename Transform>
+    uint64_t decode(std::istream& in, std::ostream& out, uint64_t outputSize, Transform transform) const {
+        BitReader reader(in);
+        return decode(reader, out, outputSize, transform);
+    }
+
+    // 从已定位的 reader 继续解码，用于在解码头部之后接着解码正文
+    template <typename Transform>
+    uint64_t decode(BitReader& reader, std::ostream& out, uint64_t outputSize, Transform transform) const {
+        const size_t chunk = 1 << 16;
+        std::vector<unsigned char> outBuffer(chunk + MAX_SYMBOL_BYTES - 1);
+        uint64_t decoded = 0;
+        while (decoded < outputSize) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(chunk, outputSize - decoded));
+            size_t got = decodeBytes(reader, outBuffer.data(), want);
+            if (got == 0) break;
+            // 最后一个符号越过数据末尾说明位流已损坏，多出的字节丢弃
+            if (got > outputSize - decoded) got = static_cast<size_t>(outputSize - decoded);
+            if (!transform(outBuffer.data(), got)) break;
+            out.write(reinterpret_cast<const char*>(outBuffer.data()), got);
+            decoded += got;
+            if (got < want) break;
+        }
+        return decoded;
+    }
+
+    uint64_t decode(std::istream& in, std::ostream& out, uint64_t outputSize) const {
+        return decode(in, out, outputSize, [](unsigned char*, size_t) { return true; });
+    }
+};
+
+#endif
@@ -100,8 +100,8 @@ bool convertToBinary() {
     getline(inFile, fileSizeStr);
     uint32_t fileSize = stoul(fileSizeStr);  // 使用无符号32位整数
 
-    // 将文件大小转换为4个字节写入
-    for (int i = 3; i >= 0; i--) {  // 从高字节到低字节
+    // 将文件大小转换为4个字节写入（小端，与 formatCodeTable 读取顺序一致）
+    for (int i = 0; i < 4; i++) {  // 从低字节到高字节
         unsigned char sizeByte = (fileSize >> (i * 8)) & 0xFF;
         outFile.put(sizeByte);
     }